@@ -0,0 +1,145 @@
+use crate::cli::{get_template_name, resolve_template_source, validate_integration, Args};
+use crate::template_processor::*;
+use crate::types::*;
+use anyhow::{anyhow, bail, Context, Result};
+use std::path::{Path, PathBuf};
+use std::time::Instant;
+
+pub async fn run_batch_mode(args: &Args, manifest_path: &Path) -> Result<()> {
+    // Project names come from the manifest
+    if args.project_name_pos.is_some() || args.project.is_some() {
+        bail!("--batch takes project names from the manifest. Remove project name argument.");
+    }
+
+    let start_time = Instant::now();
+    let content = std::fs::read_to_string(manifest_path)
+        .with_context(|| format!("Failed to read {}", manifest_path.display()))?;
+    let manifest: BatchManifest = toml::from_str(&content)
+        .with_context(|| format!("Failed to parse {}", manifest_path.display()))?;
+    if manifest.projects.is_empty() {
+        bail!("{} lists no [[project]] entries", manifest_path.display());
+    }
+    let base_dir = manifest_path.parent().unwrap_or(Path::new(""));
+
+    let available_templates = get_available_templates()?;
+    if available_templates.is_empty() {
+        bail!("No embedded templates found.");
+    }
+
+    // Command line flags are the last fallback
+    let cli_settings = BatchSettings {
+        language: args.language.clone(),
+        template: args.template.clone(),
+        integration: args.integration.clone(),
+        minimal: Some(args.minimal),
+    };
+
+    // Group the projects by template, so each is fetched and compiled once
+    let mut groups: Vec<(TemplateSource, Vec<usize>)> = Vec::new();
+    for (index, project) in manifest.projects.iter().enumerate() {
+        let source = match settings_chain(project, &manifest, &cli_settings)
+            .into_iter()
+            .find(|s| s.language.is_some() || s.template.is_some())
+        {
+            Some(s) => resolve_template_source(
+                s.language.as_ref(),
+                s.template.as_ref(),
+                &available_templates,
+            )
+            .with_context(|| format!("Project '{}'", project.path))?,
+            None => None,
+        }
+        .ok_or_else(|| anyhow!("No language or template for project '{}'", project.path))?;
+
+        match groups
+            .iter_mut()
+            .find(|(group_source, _)| source_key(group_source) == source_key(&source))
+        {
+            Some((_, indices)) => indices.push(index),
+            None => groups.push((source, vec![index])),
+        }
+    }
+
+    let mut total = RenderStats::default();
+    for (source, indices) in &groups {
+        let (template_name, template_path) =
+            get_template_name(source, &available_templates).await?;
+
+        // Load template metadata based on template type
+        let metadata = if let Some(ref path) = template_path {
+            load_template_metadata_from_path(path)?
+        } else {
+            load_template_metadata(&template_name)?
+        };
+
+        let template =
+            compile_template(&template_name, template_path.as_deref(), metadata.as_ref())?;
+
+        let mut projects: Vec<(PathBuf, serde_json::Value)> = Vec::new();
+        for &index in indices {
+            let project = &manifest.projects[index];
+            let settings = settings_chain(project, &manifest, &cli_settings);
+
+            let integration = match settings.iter().find_map(|s| s.integration.as_ref()) {
+                Some(integration) => {
+                    validate_integration(integration, metadata.as_ref())
+                        .with_context(|| format!("Project '{}'", project.path))?;
+                    integration.clone()
+                }
+                // Nobody to prompt: use the template's default
+                None => metadata
+                    .as_ref()
+                    .and_then(|m| m.integrations.as_ref())
+                    .map(|i| i.default.clone())
+                    .ok_or_else(|| {
+                        anyhow!("Template metadata is missing integration configuration")
+                    })?,
+            };
+            let minimal = settings.iter().find_map(|s| s.minimal).unwrap_or(false);
+
+            projects.push((
+                base_dir.join(&project.path),
+                template_data(&project.path, &integration, minimal),
+            ));
+        }
+
+        let stats = template.render_projects(&projects)?;
+        for (&index, stats) in indices.iter().zip(&stats) {
+            if stats.written > 0 {
+                println!(
+                    "  {}: {} written, {} unchanged",
+                    manifest.projects[index].path, stats.written, stats.unchanged
+                );
+            }
+            total.written += stats.written;
+            total.unchanged += stats.unchanged;
+        }
+    }
+
+    println!(
+        "Scaffolded {} projects in {:.1}s: {} files written, {} unchanged",
+        manifest.projects.len(),
+        start_time.elapsed().as_secs_f32(),
+        total.written,
+        total.unchanged
+    );
+
+    Ok(())
+}
+
+/// Where a project's settings are looked up, in order
+fn settings_chain<'a>(
+    project: &'a BatchProject,
+    manifest: &'a BatchManifest,
+    cli_settings: &'a BatchSettings,
+) -> [&'a BatchSettings; 3] {
+    [&project.settings, &manifest.defaults, cli_settings]
+}
+
+/// Projects with the same key share a template
+fn source_key(source: &TemplateSource) -> &str {
+    match source {
+        TemplateSource::Local(name) => name,
+        TemplateSource::GitHubFull(template) => template,
+    }
+}
@@ -100,6 +100,46 @@ Usage:\n  - fuzz-init --minimal"
     #[arg(long)]
     pub minimal: bool,
 
+    #[arg(
+        long,
+        env = "FUZZ_INIT_HARNESS_PER_FUNCTION",
+        value_name = "HEADERS",
+        long_help = "🎯 Also generate one harness per function in the project headers\n\n\
+Each harness draws the function's arguments from the input with\n\
+FuzzedDataProvider and calls the function directly (C++ template).\n\
+HEADERS is a header or a directory of headers, by default the\n\
+generated project's include/ directory.\n\n\
+Examples:\n\
+  - --harness-per-function\n\
+  - --harness-per-function ../mylib/include"
+    )]
+    #[arg(num_args = 0..=1, default_missing_value = "auto")]
+    pub harness_per_function: Option<String>,
+
+    #[arg(
+        long,
+        env = "FUZZ_INIT_BATCH",
+        value_name = "MANIFEST",
+        long_help = "📚 Scaffold every project listed in a TOML manifest\n\n\
+Each template is compiled once and the projects are rendered in\n\
+parallel; files whose rendered content is already on disk are left\n\
+untouched, so re-running after a template change only rewrites what\n\
+changed. Paths are relative to the manifest, and settings an entry\n\
+leaves out come from the top of the manifest, then from the\n\
+--language/--template/--integration/--minimal flags.\n\n\
+Example manifest:\n\
+  language = \"cpp\"\n\
+  minimal = true\n\n\
+  [[project]]\n\
+  path = \"services/parser\"\n\n\
+  [[project]]\n\
+  path = \"libs/codec\"\n\
+  integration = \"make\"\n\n\
+Example:\n\
+  - fuzz-init --batch fuzz-projects.toml"
+    )]
+    pub batch: Option<String>,
+
     #[arg(
         long,
         hide = false,
@@ -165,13 +205,34 @@ pub fn determine_template_source_with_tracking(
     args: &Args,
     available_templates: &[String],
 ) -> anyhow::Result<(TemplateSource, bool)> {
-    match (&args.language, &args.template) {
+    match resolve_template_source(
+        args.language.as_ref(),
+        args.template.as_ref(),
+        available_templates,
+    )? {
+        Some(source) => Ok((source, false)), // false = not prompted
+        // Neither specified - prompt user
+        None => {
+            let selected =
+                Select::new("Choose a language", available_templates.to_vec()).prompt()?;
+            Ok((TemplateSource::Local(selected), true)) // true = prompted
+        }
+    }
+}
+
+/// Template source for a --language or --template value; None if neither is given
+pub fn resolve_template_source(
+    language: Option<&String>,
+    template: Option<&String>,
+    available_templates: &[String],
+) -> anyhow::Result<Option<TemplateSource>> {
+    match (language, template) {
         // Language specified - use local template
         (Some(language), None) => {
             if let Some(actual_template_name) =
                 find_template_case_insensitive(language, available_templates)
             {
-                Ok((TemplateSource::Local(actual_template_name), false))
+                Ok(Some(TemplateSource::Local(actual_template_name)))
             } else {
                 anyhow::bail!(
                     "Invalid language '{}'. Available: {}",
@@ -183,11 +244,11 @@ pub fn determine_template_source_with_tracking(
         // Template specified - use remote template
         (None, Some(template)) => {
             if template.starts_with("github:") || template.starts_with('@') {
-                Ok((TemplateSource::GitHubFull(template.clone()), false))
+                Ok(Some(TemplateSource::GitHubFull(template.clone())))
             } else if let Some(actual_template_name) =
                 find_template_case_insensitive(template, available_templates)
             {
-                Ok((TemplateSource::Local(actual_template_name), false))
+                Ok(Some(TemplateSource::Local(actual_template_name)))
             } else {
                 anyhow::bail!(
                     "Invalid template '{}'. Available: {}",
@@ -200,12 +261,7 @@ pub fn determine_template_source_with_tracking(
         (Some(_), Some(_)) => {
             anyhow::bail!("Cannot specify both --language and --template. Use --language for local templates or --template for remote templates.");
         }
-        // Neither specified - prompt user
-        (None, None) => {
-            let selected =
-                Select::new("Choose a language", available_templates.to_vec()).prompt()?;
-            Ok((TemplateSource::Local(selected), true)) // true = prompted
-        }
+        (None, None) => Ok(None),
     }
 }
 
@@ -242,18 +298,7 @@ pub fn select_integration_with_tracking(
     metadata: Option<&TemplateMetadata>,
 ) -> anyhow::Result<(String, bool)> {
     if let Some(integration) = &args.integration {
-        // Validate integration type against template metadata if available
-        if let Some(metadata) = metadata {
-            if let Some(integrations) = &metadata.integrations {
-                if !integrations.supported.contains(integration) {
-                    anyhow::bail!(
-                        "Integration '{}' not supported by this template. Supported: {}",
-                        integration,
-                        integrations.supported.join(", ")
-                    );
-                }
-            }
-        }
+        validate_integration(integration, metadata)?;
         Ok((integration.clone(), false)) // false = not prompted
     } else {
         // Get default from metadata or prompt user
@@ -297,6 +342,25 @@ pub fn select_integration_with_tracking(
     }
 }
 
+/// Checks an integration type against template metadata if available
+pub fn validate_integration(
+    integration: &str,
+    metadata: Option<&TemplateMetadata>,
+) -> anyhow::Result<()> {
+    if let Some(metadata) = metadata {
+        if let Some(integrations) = &metadata.integrations {
+            if !integrations.supported.iter().any(|s| s == integration) {
+                anyhow::bail!(
+                    "Integration '{}' not supported by this template. Supported: {}",
+                    integration,
+                    integrations.supported.join(", ")
+                );
+            }
+        }
+    }
+    Ok(())
+}
+
 pub fn print_next_steps(
     project_name: &str,
     minimal_mode: bool,
@@ -1,8 +1,8 @@
 use anyhow::{bail, Context};
 use clap::Parser;
-use serde_json::json;
-use std::path::Path;
+use std::path::{Path, PathBuf};
 
+mod batch_mode;
 mod cli;
 mod dev_mode;
 mod github_fetcher;
@@ -28,6 +28,11 @@ async fn main() -> anyhow::Result<()> {
         return dev_mode::run_dev_mode(&args).await;
     }
 
+    // Check if a batch of projects was requested
+    if let Some(ref manifest) = args.batch {
+        return batch_mode::run_batch_mode(&args, Path::new(manifest)).await;
+    }
+
     // Get available templates
     let available_templates = get_available_templates()?;
     if available_templates.is_empty() {
@@ -64,19 +69,7 @@ async fn main() -> anyhow::Result<()> {
     // Setup Handlebars with helpers
     let handlebars = setup_handlebars();
 
-    // Extract base name for filenames (remove path components)
-    let project_basename = Path::new(&project_name)
-        .file_name()
-        .unwrap_or_default()
-        .to_string_lossy()
-        .to_string();
-
-    let data = json!({
-        "project_name": project_name,
-        "target_name": project_basename, // Use base name only for template filenames
-        "integration": integration_type,
-        "minimal": minimal_mode
-    });
+    let data = template_data(&project_name, &integration_type, minimal_mode);
 
     // Generate project - handle nested paths properly
     let out_path = Path::new(&project_name);
@@ -109,6 +102,28 @@ async fn main() -> anyhow::Result<()> {
         )?;
     }
 
+    if let Some(ref headers) = args.harness_per_function {
+        let header_path = if headers == "auto" {
+            out_path.join("include")
+        } else {
+            PathBuf::from(headers)
+        };
+        let generated = generate_function_harnesses(out_path, &header_path)
+            .context("Failed to generate per-function harnesses")?;
+
+        println!(
+            "Generated {} per-function harnesses from {}:",
+            generated.harnesses.len(),
+            header_path.display()
+        );
+        for stem in &generated.harnesses {
+            println!("  fuzz/src/{stem}.cpp");
+        }
+        for (signature, reason) in &generated.skipped {
+            println!("  skipped {signature}: {reason}");
+        }
+    }
+
     // Success message with next steps
     println!("Project '{project_name}' created with {template_name} template!");
 
@@ -1,6 +1,14 @@
 use crate::types::*;
+use anyhow::Context;
 use handlebars::Handlebars;
-use std::{fs, path::Path};
+use serde_json::json;
+use std::collections::{HashMap, HashSet};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::{
+    fs,
+    path::{Path, PathBuf},
+    thread,
+};
 
 // Conditional template loading based on build mode
 #[cfg(not(debug_assertions))]
@@ -344,10 +352,7 @@ fn should_include_by_convention(
 // Evaluate condition using Handlebars built-in helpers
 fn evaluate_condition(condition: &str, data: &serde_json::Value) -> bool {
     let handlebars = setup_handlebars();
-
-    // Convert condition to Handlebars template format
-    let handlebars_condition = convert_condition_to_handlebars(condition);
-    let template = format!("{{{{#if {handlebars_condition}}}}}true{{{{/if}}}}");
+    let template = condition_template(condition);
 
     match handlebars.render_template(&template, data) {
         Ok(result) => result.trim() == "true",
@@ -355,6 +360,13 @@ fn evaluate_condition(condition: &str, data: &serde_json::Value) -> bool {
     }
 }
 
+/// A template that renders "true" when `condition` holds
+fn condition_template(condition: &str) -> String {
+    // Convert condition to Handlebars template format
+    let handlebars_condition = convert_condition_to_handlebars(condition);
+    format!("{{{{#if {handlebars_condition}}}}}true{{{{/if}}}}")
+}
+
 pub fn convert_condition_to_handlebars(condition: &str) -> String {
     // Handle AND conditions first (higher precedence)
     if condition.contains("&&") {
@@ -555,3 +567,1280 @@ fn should_skip_directory(
     };
     metadata.file_conventions.full_mode_only.contains(file_name)
 }
+
+/// Template data for a project, as every generation mode passes it
+pub fn template_data(project_name: &str, integration: &str, minimal: bool) -> serde_json::Value {
+    // Extract base name for filenames (remove path components)
+    let project_basename = Path::new(project_name)
+        .file_name()
+        .unwrap_or_default()
+        .to_string_lossy()
+        .to_string();
+
+    json!({
+        "project_name": project_name,
+        "target_name": project_basename, // Use base name only for template filenames
+        "integration": integration,
+        "minimal": minimal
+    })
+}
+
+// ===== Batch rendering =====
+//
+// Scaffolds many projects from one template. compile_template reads the
+// template once and registers its contents, templated file and directory
+// names and file conditions as named Handlebars templates, resolving what
+// only depends on the metadata up front. render_projects then renders every
+// (project, file) pair on a pool of threads and only writes files whose
+// content differs from what's on disk, so a re-run leaves untouched files
+// (and the builds depending on their mtimes) alone.
+
+/// A template compiled for rendering into any number of projects
+pub struct CompiledTemplate {
+    handlebars: Handlebars<'static>,
+    entries: Vec<CompiledEntry>,
+}
+
+/// A directory or file of the template
+struct CompiledEntry {
+    /// Output path relative to the project, one part per component
+    components: Vec<NamePart>,
+    /// Left out of minimal mode by the file conventions
+    full_mode_only: bool,
+    /// None for directories
+    file: Option<CompiledFile>,
+}
+
+struct CompiledFile {
+    content: FileContent,
+    /// Registered template of the file's `condition`, if it has one
+    condition: Option<String>,
+    executable: bool,
+}
+
+enum NamePart {
+    Literal(String),
+    Template(String),
+}
+
+enum FileContent {
+    /// Registered template name
+    Template(String),
+    /// Copied as-is: untemplated and binary files
+    Raw(Vec<u8>),
+}
+
+/// A template directory (`contents` None) or file, by path relative to its root
+struct TemplateEntry {
+    relative_path: String,
+    contents: Option<Vec<u8>>,
+}
+
+/// Compiles the embedded template `template_name`, or the one at
+/// `template_path` when given (remote templates)
+pub fn compile_template(
+    template_name: &str,
+    template_path: Option<&Path>,
+    metadata: Option<&TemplateMetadata>,
+) -> anyhow::Result<CompiledTemplate> {
+    let mut entries = Vec::new();
+    if let Some(path) = template_path {
+        collect_filesystem_entries(path, "", &mut entries)?;
+    } else {
+        #[cfg(not(debug_assertions))]
+        {
+            // Release mode: use embedded templates
+            let Some(template_dir) = TEMPLATES_DIR.get_dir(template_name) else {
+                anyhow::bail!("Template '{}' not found", template_name);
+            };
+            collect_embedded_entries(template_dir, "", &mut entries);
+        }
+
+        #[cfg(debug_assertions)]
+        {
+            // Debug mode: use filesystem templates
+            let template_dir = Path::new(TEMPLATES_PATH).join(template_name);
+            if !template_dir.exists() {
+                anyhow::bail!("Template '{}' not found", template_name);
+            }
+            collect_filesystem_entries(&template_dir, "", &mut entries)?;
+        }
+    }
+
+    let mut handlebars = setup_handlebars();
+    let minimal_data = json!({ "minimal": true });
+    let mut compiled = Vec::new();
+    for entry in entries {
+        let relative_path = entry.relative_path;
+        let names: Vec<&str> = relative_path.split('/').collect();
+        let file_name = names[names.len() - 1];
+
+        // Skip template.toml configuration files - they should not be copied
+        if entry.contents.is_some() && file_name == "template.toml" {
+            continue;
+        }
+
+        // Directory inclusion rules only look at the top level
+        let in_full_mode_dir = (entry.contents.is_none() || names.len() > 1)
+            && should_skip_directory(metadata, &minimal_data, "", &names[0].to_string());
+
+        let file_config = get_file_config(metadata, &relative_path);
+        let file = match entry.contents {
+            None => None,
+            Some(contents) => {
+                let condition = match file_config.and_then(|fc| fc.condition()) {
+                    Some(condition) => {
+                        let name = format!("condition:{condition}");
+                        if !handlebars.has_template(&name)
+                            && handlebars
+                                .register_template_string(&name, condition_template(condition))
+                                .is_err()
+                        {
+                            // Like evaluate_condition, a condition that doesn't parse never holds
+                            handlebars.register_template_string(&name, "")?;
+                        }
+                        Some(name)
+                    }
+                    None => None,
+                };
+                let content = match String::from_utf8(contents) {
+                    Ok(text) if file_config.is_none_or(|fc| fc.should_template()) => {
+                        handlebars
+                            .register_template_string(&relative_path, text)
+                            .with_context(|| format!("Failed to compile {relative_path}"))?;
+                        FileContent::Template(relative_path.clone())
+                    }
+                    Ok(text) => FileContent::Raw(text.into_bytes()),
+                    Err(err) => FileContent::Raw(err.into_bytes()),
+                };
+                Some(CompiledFile {
+                    content,
+                    condition,
+                    executable: file_config.is_some_and(|fc| fc.is_executable()),
+                })
+            }
+        };
+
+        // Conventions apply to files without an explicit condition
+        let full_mode_only = in_full_mode_dir
+            || file.as_ref().is_some_and(|file| {
+                file.condition.is_none()
+                    && !should_include_file(metadata, &relative_path, &minimal_data)
+            });
+
+        // Directory names are always templated, file names when the content is
+        let templated_file_name = file
+            .as_ref()
+            .is_some_and(|_| file_config.is_none_or(|fc| fc.should_template()));
+        let mut components = Vec::with_capacity(names.len());
+        for (i, name) in names.iter().enumerate() {
+            let is_file_name = file.is_some() && i == names.len() - 1;
+            if !name.contains("{{") || (is_file_name && !templated_file_name) {
+                components.push(NamePart::Literal(name.to_string()));
+                continue;
+            }
+            let template_name = format!("name:{}", names[..=i].join("/"));
+            if !handlebars.has_template(&template_name) {
+                handlebars
+                    .register_template_string(&template_name, *name)
+                    .with_context(|| format!("Failed to compile the name of {relative_path}"))?;
+            }
+            components.push(NamePart::Template(template_name));
+        }
+
+        compiled.push(CompiledEntry {
+            components,
+            full_mode_only,
+            file,
+        });
+    }
+
+    Ok(CompiledTemplate {
+        handlebars,
+        entries: compiled,
+    })
+}
+
+fn collect_filesystem_entries(
+    template_dir: &Path,
+    relative_path: &str,
+    entries: &mut Vec<TemplateEntry>,
+) -> anyhow::Result<()> {
+    for entry in fs::read_dir(template_dir)? {
+        let entry = entry?;
+        let file_type = entry.file_type()?;
+        let file_name = entry.file_name().to_string_lossy().to_string();
+        let current_relative_path = if relative_path.is_empty() {
+            file_name
+        } else {
+            format!("{relative_path}/{file_name}")
+        };
+
+        if file_type.is_dir() {
+            entries.push(TemplateEntry {
+                relative_path: current_relative_path.clone(),
+                contents: None,
+            });
+            collect_filesystem_entries(&entry.path(), &current_relative_path, entries)?;
+        } else if file_type.is_file() {
+            entries.push(TemplateEntry {
+                relative_path: current_relative_path,
+                contents: Some(fs::read(entry.path())?),
+            });
+        }
+    }
+    Ok(())
+}
+
+#[cfg(not(debug_assertions))]
+fn collect_embedded_entries(
+    template_dir: &include_dir::Dir,
+    relative_path: &str,
+    entries: &mut Vec<TemplateEntry>,
+) {
+    let join = |name: &str| {
+        if relative_path.is_empty() {
+            name.to_string()
+        } else {
+            format!("{relative_path}/{name}")
+        }
+    };
+
+    for file in template_dir.files() {
+        let file_name = file.path().file_name().unwrap().to_str().unwrap();
+        entries.push(TemplateEntry {
+            relative_path: join(file_name),
+            contents: Some(file.contents().to_vec()),
+        });
+    }
+
+    for subdir in template_dir.dirs() {
+        let subdir_name = subdir.path().file_name().unwrap().to_str().unwrap();
+        let current_relative_path = join(subdir_name);
+        entries.push(TemplateEntry {
+            relative_path: current_relative_path.clone(),
+            contents: None,
+        });
+        collect_embedded_entries(subdir, &current_relative_path, entries);
+    }
+}
+
+enum RenderOutcome {
+    Written,
+    Unchanged,
+    /// Condition false, or rendered empty
+    Skipped,
+}
+
+impl CompiledTemplate {
+    /// Renders the template into each (output directory, data) project, using
+    /// up to one thread per CPU. Returns what happened to each project's files.
+    pub fn render_projects(
+        &self,
+        projects: &[(PathBuf, serde_json::Value)],
+    ) -> anyhow::Result<Vec<RenderStats>> {
+        // Directories first, so the file jobs below can run in any order
+        let mut jobs = Vec::new();
+        for (project, (output_dir, data)) in projects.iter().enumerate() {
+            let minimal = is_minimal(data);
+            fs::create_dir_all(output_dir)?;
+            for (index, entry) in self.entries.iter().enumerate() {
+                if minimal && entry.full_mode_only {
+                    continue;
+                }
+                if entry.file.is_some() {
+                    jobs.push((project, index));
+                } else {
+                    fs::create_dir_all(self.output_path(output_dir, entry, data)?)?;
+                }
+            }
+        }
+
+        let next_job = AtomicUsize::new(0);
+        let workers = thread::available_parallelism()
+            .map_or(1, |n| n.get())
+            .min(jobs.len())
+            .max(1);
+        let outcomes = thread::scope(|scope| {
+            let handles: Vec<_> = (0..workers)
+                .map(|_| {
+                    scope.spawn(|| -> anyhow::Result<Vec<(usize, RenderOutcome)>> {
+                        let mut outcomes = Vec::new();
+                        loop {
+                            let job = next_job.fetch_add(1, Ordering::Relaxed);
+                            let Some(&(project, index)) = jobs.get(job) else {
+                                return Ok(outcomes);
+                            };
+                            let (output_dir, data) = &projects[project];
+                            let entry = &self.entries[index];
+                            let outcome =
+                                self.render_file(output_dir, entry, data).with_context(|| {
+                                    format!("Failed to render into {}", output_dir.display())
+                                })?;
+                            outcomes.push((project, outcome));
+                        }
+                    })
+                })
+                .collect();
+            handles
+                .into_iter()
+                .map(|handle| handle.join().expect("render thread panicked"))
+                .collect::<anyhow::Result<Vec<_>>>()
+        })?;
+
+        let mut stats = vec![RenderStats::default(); projects.len()];
+        for (project, outcome) in outcomes.into_iter().flatten() {
+            match outcome {
+                RenderOutcome::Written => stats[project].written += 1,
+                RenderOutcome::Unchanged => stats[project].unchanged += 1,
+                RenderOutcome::Skipped => {}
+            }
+        }
+        Ok(stats)
+    }
+
+    fn render_file(
+        &self,
+        output_dir: &Path,
+        entry: &CompiledEntry,
+        data: &serde_json::Value,
+    ) -> anyhow::Result<RenderOutcome> {
+        let Some(file) = &entry.file else {
+            return Ok(RenderOutcome::Skipped);
+        };
+
+        // Check if this file should be included based on conditions
+        if let Some(condition) = &file.condition {
+            let holds = self
+                .handlebars
+                .render(condition, data)
+                .is_ok_and(|result| result.trim() == "true");
+            if !holds {
+                return Ok(RenderOutcome::Skipped);
+            }
+        }
+
+        let rendered;
+        let content = match &file.content {
+            FileContent::Template(name) => {
+                rendered = self.handlebars.render(name, data)?;
+                // Skip empty files (allows Handlebars conditionals to hide entire files)
+                if rendered.trim().is_empty() {
+                    return Ok(RenderOutcome::Skipped);
+                }
+                rendered.as_bytes()
+            }
+            FileContent::Raw(bytes) => bytes.as_slice(),
+        };
+
+        let output_path = self.output_path(output_dir, entry, data)?;
+        let unchanged = fs::metadata(&output_path)
+            .is_ok_and(|existing| existing.len() == content.len() as u64)
+            && fs::read(&output_path).is_ok_and(|existing| existing == content);
+        if !unchanged {
+            fs::write(&output_path, content)?;
+        }
+
+        // Set executable permissions if needed
+        if file.executable {
+            set_executable(&output_path)?;
+        }
+
+        Ok(if unchanged {
+            RenderOutcome::Unchanged
+        } else {
+            RenderOutcome::Written
+        })
+    }
+
+    fn output_path(
+        &self,
+        output_dir: &Path,
+        entry: &CompiledEntry,
+        data: &serde_json::Value,
+    ) -> anyhow::Result<PathBuf> {
+        let mut path = output_dir.to_path_buf();
+        for component in &entry.components {
+            match component {
+                NamePart::Literal(name) => path.push(name),
+                NamePart::Template(name) => path.push(self.handlebars.render(name, data)?),
+            }
+        }
+        Ok(path)
+    }
+}
+
+// ===== Per-function harness generation =====
+//
+// Reads the function declarations from a project's headers and writes one
+// harness per function to fuzz/src. Each harness draws the function's
+// arguments from the input with FuzzedDataProvider (fuzz/src/fuzz_data_provider.h)
+// and calls it directly, skipping whatever front-end parsing fuzz_harness_1
+// goes through. fuzz/CMakeLists.txt lists the new sources explicitly;
+// fuzz/Makefile picks up src/*.cpp on its own.
+
+const HEADER_EXTENSIONS: &[&str] = &["h", "hh", "hpp", "hxx"];
+
+/// Line in fuzz/CMakeLists.txt's FUZZ_HARNESS_SRCS that new sources go above
+const HARNESS_SRCS_MARKER: &str = "# add more harness file sources here.";
+
+/// Elements an output array parameter gets at most
+const MAX_OUTPUT_ELEMENTS: usize = 4096;
+
+const INTEGRAL_TYPES: &[&str] = &[
+    "char",
+    "signed char",
+    "unsigned char",
+    "short",
+    "short int",
+    "unsigned short",
+    "unsigned short int",
+    "int",
+    "signed",
+    "signed int",
+    "unsigned",
+    "unsigned int",
+    "long",
+    "long int",
+    "unsigned long",
+    "unsigned long int",
+    "long long",
+    "long long int",
+    "unsigned long long",
+    "unsigned long long int",
+    "int8_t",
+    "uint8_t",
+    "int16_t",
+    "uint16_t",
+    "int32_t",
+    "uint32_t",
+    "int64_t",
+    "uint64_t",
+    "size_t",
+    "ssize_t",
+    "intptr_t",
+    "uintptr_t",
+    "ptrdiff_t",
+];
+
+const FLOATING_TYPES: &[&str] = &["float", "double", "long double"];
+
+const BYTE_TYPES: &[&str] = &["char", "signed char", "unsigned char", "int8_t", "uint8_t"];
+
+/// Writes fuzz/src/fuzz_<function>.cpp under `output_dir` for every function
+/// declared in `header_path` (a header, or a directory searched recursively)
+/// whose parameters can be drawn from fuzz input, and registers them in
+/// fuzz/CMakeLists.txt when there is one. Existing generated harnesses are
+/// overwritten.
+pub fn generate_function_harnesses(
+    output_dir: &Path,
+    header_path: &Path,
+) -> anyhow::Result<GeneratedHarnesses> {
+    let src_dir = output_dir.join("fuzz").join("src");
+    if !src_dir.join("fuzz_data_provider.h").exists() {
+        anyhow::bail!(
+            "{} has no fuzz_data_provider.h; per-function harnesses need the C++ template",
+            src_dir.display()
+        );
+    }
+
+    let (header_root, headers) = collect_headers(header_path)?;
+    if headers.is_empty() {
+        anyhow::bail!("No headers found in {}", header_path.display());
+    }
+
+    let mut functions = Vec::new();
+    let mut object_types = HashMap::new();
+    for header in &headers {
+        let include = header
+            .strip_prefix(&header_root)
+            .unwrap_or(header)
+            .to_string_lossy()
+            .replace('\\', "/");
+        let text = fs::read_to_string(header)?;
+        parse_header_declarations(&text, &include, &mut functions, &mut object_types);
+    }
+
+    let mut result = GeneratedHarnesses::default();
+    let mut seen = HashSet::new();
+    let mut stem_counts: HashMap<String, usize> = HashMap::new();
+    for function in &functions {
+        let signature = function_signature(function);
+        if !seen.insert(signature.clone()) {
+            continue; // declared again, or declared and then defined
+        }
+
+        let args = match plan_arguments(function, &object_types) {
+            Ok(args) => args,
+            Err(reason) => {
+                result.skipped.push((signature, reason));
+                continue;
+            }
+        };
+
+        // Overloads get numbered: fuzz_process, fuzz_process_2, ...
+        let base = format!("fuzz_{}", function.name.replace("::", "_"));
+        let count = stem_counts.entry(base.clone()).or_insert(0);
+        *count += 1;
+        let stem = if *count == 1 {
+            base
+        } else {
+            format!("{base}_{count}")
+        };
+
+        let source = render_function_harness(function, &signature, &args);
+        fs::write(src_dir.join(format!("{stem}.cpp")), source)?;
+        result.harnesses.push(stem);
+    }
+
+    let cmake_lists = output_dir.join("fuzz").join("CMakeLists.txt");
+    if cmake_lists.exists() && !result.harnesses.is_empty() {
+        register_cmake_harnesses(&cmake_lists, &result.harnesses)?;
+    }
+
+    Ok(result)
+}
+
+/// Returns the directory includes are relative to, and the headers in it
+fn collect_headers(header_path: &Path) -> anyhow::Result<(PathBuf, Vec<PathBuf>)> {
+    if header_path.is_file() {
+        let root = header_path.parent().unwrap_or(Path::new("")).to_path_buf();
+        return Ok((root, vec![header_path.to_path_buf()]));
+    }
+    if !header_path.is_dir() {
+        anyhow::bail!("Header path '{}' not found", header_path.display());
+    }
+
+    let mut headers = Vec::new();
+    collect_headers_recursive(header_path, &mut headers)?;
+    Ok((header_path.to_path_buf(), headers))
+}
+
+fn collect_headers_recursive(dir: &Path, headers: &mut Vec<PathBuf>) -> anyhow::Result<()> {
+    let mut entries = fs::read_dir(dir)?.collect::<Result<Vec<_>, _>>()?;
+    entries.sort_by_key(|entry| entry.file_name());
+
+    for entry in entries {
+        let path = entry.path();
+        if entry.file_type()?.is_dir() {
+            collect_headers_recursive(&path, headers)?;
+        } else if path
+            .extension()
+            .and_then(|ext| ext.to_str())
+            .is_some_and(|ext| HEADER_EXTENSIONS.contains(&ext))
+        {
+            headers.push(path);
+        }
+    }
+
+    Ok(())
+}
+
+/// Removes comments and preprocessor lines, keeping string literals intact
+fn strip_comments_and_directives(text: &str) -> String {
+    let mut out = String::with_capacity(text.len());
+    let mut chars = text.chars().peekable();
+    let mut at_line_start = true;
+
+    while let Some(c) = chars.next() {
+        match c {
+            '/' if chars.peek() == Some(&'/') => {
+                while chars.peek().is_some_and(|&next| next != '\n') {
+                    chars.next();
+                }
+            }
+            '/' if chars.peek() == Some(&'*') => {
+                chars.next();
+                let mut prev = '\0';
+                for next in chars.by_ref() {
+                    if prev == '*' && next == '/' {
+                        break;
+                    }
+                    prev = next;
+                }
+                out.push(' ');
+            }
+            '#' if at_line_start => {
+                // The directive and its continuation lines
+                let mut prev = '\0';
+                for next in chars.by_ref() {
+                    if next == '\n' && prev != '\\' {
+                        break;
+                    }
+                    prev = next;
+                }
+                out.push('\n');
+                continue;
+            }
+            '"' | '\'' => {
+                out.push(c);
+                let mut escaped = false;
+                for next in chars.by_ref() {
+                    out.push(next);
+                    if escaped {
+                        escaped = false;
+                    } else if next == '\\' {
+                        escaped = true;
+                    } else if next == c {
+                        break;
+                    }
+                }
+            }
+            _ => out.push(c),
+        }
+        at_line_start = c == '\n' || (at_line_start && c.is_whitespace());
+    }
+
+    out
+}
+
+/// Finds the functions declared (or defined inline) at namespace scope, and
+/// the names of the struct, class and typedef'd types they may take pointers to
+fn parse_header_declarations(
+    text: &str,
+    header: &str,
+    functions: &mut Vec<HeaderFunction>,
+    object_types: &mut HashMap<String, String>,
+) {
+    let code = strip_comments_and_directives(text);
+    // Enclosing namespace and extern "C" blocks; None for extern "C"
+    let mut scopes: Vec<Option<String>> = Vec::new();
+    let mut statement = String::new();
+    let mut chars = code.chars();
+
+    while let Some(c) = chars.next() {
+        match c {
+            ';' => {
+                let s = collapse_whitespace(&statement);
+                if let Some(name) = typedef_name(&s) {
+                    add_object_type(object_types, &scopes, &name);
+                } else if let Some(function) = parse_function_declaration(&s, &scopes, header) {
+                    functions.push(function);
+                }
+                statement.clear();
+            }
+            '{' => {
+                let head = collapse_whitespace(&statement);
+                if let Some(namespace) = namespace_name(&head) {
+                    scopes.push(Some(namespace));
+                    statement.clear();
+                } else if head == "extern \"C\"" || head == "extern \"C++\"" {
+                    scopes.push(None);
+                    statement.clear();
+                } else {
+                    // A struct/class/union/enum body or an inline function body
+                    if let Some(name) = record_name(&head) {
+                        add_object_type(object_types, &scopes, &name);
+                    } else if let Some(function) =
+                        parse_function_declaration(&head, &scopes, header)
+                    {
+                        functions.push(function);
+                    }
+                    skip_block(&mut chars);
+                    // `typedef struct {...} Name;` names the type after the body
+                    statement = if head.starts_with("typedef ") {
+                        "typedef struct ".to_string()
+                    } else {
+                        String::new()
+                    };
+                }
+            }
+            '}' => {
+                scopes.pop();
+                statement.clear();
+            }
+            _ => statement.push(c),
+        }
+    }
+}
+
+/// Skips to the '}' matching an already consumed '{'
+fn skip_block(chars: &mut std::str::Chars) {
+    let mut depth = 1;
+    for c in chars.by_ref() {
+        match c {
+            '{' => depth += 1,
+            '}' => {
+                depth -= 1;
+                if depth == 0 {
+                    return;
+                }
+            }
+            _ => {}
+        }
+    }
+}
+
+fn collapse_whitespace(s: &str) -> String {
+    s.split_whitespace().collect::<Vec<_>>().join(" ")
+}
+
+fn is_identifier(s: &str) -> bool {
+    let mut chars = s.chars();
+    chars
+        .next()
+        .is_some_and(|c| c.is_ascii_alphabetic() || c == '_')
+        && chars.all(|c| c.is_ascii_alphanumeric() || c == '_')
+}
+
+fn qualified_name(scopes: &[Option<String>], name: &str) -> String {
+    let mut parts: Vec<&str> = scopes
+        .iter()
+        .flatten()
+        .map(String::as_str)
+        .filter(|s| !s.is_empty())
+        .collect();
+    parts.push(name);
+    parts.join("::")
+}
+
+/// Object types are looked up by both their plain and qualified names
+fn add_object_type(
+    object_types: &mut HashMap<String, String>,
+    scopes: &[Option<String>],
+    name: &str,
+) {
+    let qualified = qualified_name(scopes, name);
+    object_types.insert(name.to_string(), qualified.clone());
+    object_types.insert(qualified.clone(), qualified);
+}
+
+/// "namespace a::b" or "inline namespace v1" opens a namespace; "" if anonymous
+fn namespace_name(head: &str) -> Option<String> {
+    let head = head.strip_prefix("inline ").unwrap_or(head);
+    let rest = head.strip_prefix("namespace")?;
+    if rest.is_empty() {
+        return Some(String::new());
+    }
+    let name = rest.strip_prefix(' ')?;
+    name.split("::")
+        .all(is_identifier)
+        .then(|| name.to_string())
+}
+
+/// Name of a `struct X`/`class X`/`union X` body, ignoring base classes
+fn record_name(head: &str) -> Option<String> {
+    let head = head.strip_prefix("typedef ").unwrap_or(head);
+    let mut words = head.split([' ', ':']);
+    if !matches!(words.next()?, "struct" | "class" | "union") {
+        return None;
+    }
+    let name = words.find(|w| !w.is_empty() && *w != "final")?;
+    is_identifier(name).then(|| name.to_string())
+}
+
+/// The new name in `typedef ... Name` and `using Name = ...`
+fn typedef_name(statement: &str) -> Option<String> {
+    if let Some(rest) = statement.strip_prefix("using ") {
+        let (name, _) = rest.split_once('=')?;
+        let name = name.trim();
+        return is_identifier(name).then(|| name.to_string());
+    }
+    let rest = statement.strip_prefix("typedef ")?;
+    let name = rest.rsplit(' ').next()?;
+    is_identifier(name).then(|| name.to_string())
+}
+
+fn parse_function_declaration(
+    statement: &str,
+    scopes: &[Option<String>],
+    header: &str,
+) -> Option<HeaderFunction> {
+    const SKIPPED_PREFIXES: &[&str] = &["typedef ", "using ", "template", "friend ", "return "];
+    if SKIPPED_PREFIXES.iter().any(|p| statement.starts_with(p)) || statement.contains("operator") {
+        return None;
+    }
+
+    let open = statement.find('(')?;
+    let close = matching_paren(statement, open)?;
+    let trailer = statement[close + 1..].trim();
+    if !matches!(trailer, "" | "noexcept" | "throw()") {
+        return None;
+    }
+
+    // Specifiers that don't change how the function is called
+    let mut head = statement[..open].trim();
+    loop {
+        let stripped = [
+            "extern \"C\" ",
+            "static ",
+            "inline ",
+            "extern ",
+            "constexpr ",
+            "[[nodiscard]] ",
+        ]
+        .iter()
+        .find_map(|p| head.strip_prefix(p));
+        match stripped {
+            Some(rest) => head = rest.trim_start(),
+            None => break,
+        }
+    }
+
+    let name_start = head
+        .rfind(|c: char| !(c.is_ascii_alphanumeric() || c == '_'))
+        .map_or(0, |i| i + 1);
+    let name = &head[name_start..];
+    let return_type = normalize_type(&head[..name_start]);
+    // Macro invocations and constructors have no return type; initializers have '='
+    // Out-of-class definitions (`int ns::f(...)`) too
+    if !is_identifier(name)
+        || name == "main"
+        || return_type.is_empty()
+        || return_type.contains(['=', '('])
+        || return_type.ends_with(':')
+    {
+        return None;
+    }
+
+    let params_text = statement[open + 1..close].trim();
+    let params = if params_text.is_empty() || params_text == "void" {
+        Vec::new()
+    } else {
+        split_top_level(params_text, ',')
+            .into_iter()
+            .map(|p| parse_param(&p))
+            .collect()
+    };
+
+    Some(HeaderFunction {
+        name: qualified_name(scopes, name),
+        return_type,
+        params,
+        header: header.to_string(),
+    })
+}
+
+fn matching_paren(s: &str, open: usize) -> Option<usize> {
+    let mut depth = 0;
+    for (i, c) in s[open..].char_indices() {
+        match c {
+            '(' => depth += 1,
+            ')' => {
+                depth -= 1;
+                if depth == 0 {
+                    return Some(open + i);
+                }
+            }
+            _ => {}
+        }
+    }
+    None
+}
+
+/// Splits on `sep` outside of (), <> and [] nesting
+fn split_top_level(s: &str, sep: char) -> Vec<String> {
+    let mut parts = Vec::new();
+    let mut depth = 0i32;
+    let mut current = String::new();
+    for c in s.chars() {
+        match c {
+            '(' | '<' | '[' => depth += 1,
+            ')' | '>' | ']' => depth -= 1,
+            _ if c == sep && depth == 0 => {
+                parts.push(current.trim().to_string());
+                current.clear();
+                continue;
+            }
+            _ => {}
+        }
+        current.push(c);
+    }
+    parts.push(current.trim().to_string());
+    parts
+}
+
+/// Single spaces, '*' and '&' attached to the type: "const uint8_t* data"
+fn normalize_type(ty: &str) -> String {
+    let mut out = String::new();
+    for c in ty.chars() {
+        if c.is_whitespace() {
+            if !out.is_empty() && !out.ends_with(' ') {
+                out.push(' ');
+            }
+            continue;
+        }
+        if matches!(c, '*' | '&') && out.ends_with(' ') {
+            out.pop();
+        }
+        if (c.is_ascii_alphanumeric() || c == '_') && (out.ends_with('*') || out.ends_with('&')) {
+            out.push(' ');
+        }
+        out.push(c);
+    }
+    out.trim_end().to_string()
+}
+
+fn parse_param(param: &str) -> HeaderParam {
+    // Drop a default argument
+    let param = split_top_level(param, '=').swap_remove(0);
+    let param = normalize_type(&param);
+
+    const TYPE_WORDS: &[&str] = &[
+        "char", "short", "int", "long", "signed", "unsigned", "float", "double", "bool", "const",
+        "volatile", "struct", "class", "union", "enum",
+    ];
+    if let Some((ty, name)) = param.rsplit_once(' ') {
+        if is_identifier(name) && !TYPE_WORDS.contains(&name) && !ty.is_empty() {
+            return HeaderParam {
+                ty: ty.to_string(),
+                name: Some(name.to_string()),
+            };
+        }
+    }
+    HeaderParam {
+        ty: param,
+        name: None,
+    }
+}
+
+fn function_signature(function: &HeaderFunction) -> String {
+    let params: Vec<String> = function
+        .params
+        .iter()
+        .map(|p| match &p.name {
+            Some(name) => format!("{} {}", p.ty, name),
+            None => p.ty.clone(),
+        })
+        .collect();
+    format!(
+        "{} {}({})",
+        function.return_type,
+        function.name,
+        params.join(", ")
+    )
+}
+
+/// How a harness produces one or two of a function's arguments
+enum ArgPlan {
+    /// `T v = fdp.Consume...<T>();`
+    Scalar {
+        ty: String,
+        var: String,
+        consume: String,
+    },
+    /// `T v{};` passed as &v
+    OutObject { ty: String, var: String },
+    /// `std::vector<T> v(n)` with n drawn from the input, passed as v.data(), n
+    OutArray {
+        elem: String,
+        var: String,
+        count_ty: String,
+        count_var: String,
+    },
+    /// A byte range passed as v.data(), v.size()
+    Bytes {
+        elem: String,
+        var: String,
+        size_ty: String,
+    },
+    /// NUL-terminated copy in a std::vector<char>, passed as v.data()
+    MutableString { var: String },
+    /// std::string, passed as v.c_str() or v
+    String { var: String, c_str: bool },
+}
+
+impl ArgPlan {
+    /// Byte ranges and strings split what's left of the input between them
+    fn is_variable_length(&self) -> bool {
+        matches!(
+            self,
+            ArgPlan::Bytes { .. } | ArgPlan::MutableString { .. } | ArgPlan::String { .. }
+        )
+    }
+
+    /// `last` is set for the last variable-length argument, which gets the rest of the input
+    fn declaration(&self, last: bool) -> String {
+        let length = if last {
+            "fdp.remaining_bytes()"
+        } else {
+            "fdp.ConsumeIntegralInRange<size_t>(0, fdp.remaining_bytes())"
+        };
+        match self {
+            ArgPlan::Scalar { ty, var, consume } => format!("    {ty} {var} = {consume};\n"),
+            ArgPlan::OutObject { ty, var } => format!("    {ty} {var}{{}};\n"),
+            ArgPlan::OutArray {
+                elem,
+                var,
+                count_ty,
+                count_var,
+            } => format!(
+                "    {count_ty} {count_var} = fdp.ConsumeIntegralInRange<{count_ty}>(0, {MAX_OUTPUT_ELEMENTS});\n    std::vector<{elem}> {var}({count_var});\n"
+            ),
+            ArgPlan::Bytes { elem, var, .. } => {
+                format!("    std::vector<{elem}> {var} = fdp.ConsumeBytes<{elem}>({length});\n")
+            }
+            ArgPlan::MutableString { var } => format!(
+                "    std::vector<char> {var} = fdp.ConsumeBytesWithTerminator<char>({length}, '\\0');\n"
+            ),
+            ArgPlan::String { var, .. } => {
+                if last {
+                    format!("    std::string {var} = fdp.ConsumeRemainingBytesAsString();\n")
+                } else {
+                    format!("    std::string {var} = fdp.ConsumeRandomLengthString();\n")
+                }
+            }
+        }
+    }
+
+    fn call_args(&self) -> Vec<String> {
+        match self {
+            ArgPlan::Scalar { var, .. } => vec![var.clone()],
+            ArgPlan::OutObject { var, .. } => vec![format!("&{var}")],
+            ArgPlan::OutArray { var, count_var, .. } => {
+                vec![format!("{var}.data()"), count_var.clone()]
+            }
+            ArgPlan::Bytes { var, size_ty, .. } => {
+                let size = if size_ty == "size_t" || size_ty == "std::size_t" {
+                    format!("{var}.size()")
+                } else {
+                    format!("static_cast<{size_ty}>({var}.size())")
+                };
+                vec![format!("{var}.data()"), size]
+            }
+            ArgPlan::MutableString { var } => vec![format!("{var}.data()")],
+            ArgPlan::String { var, c_str } => {
+                if *c_str {
+                    vec![format!("{var}.c_str()")]
+                } else {
+                    vec![var.clone()]
+                }
+            }
+        }
+    }
+}
+
+fn base_type(ty: &str) -> &str {
+    let ty = ty.strip_prefix("const ").unwrap_or(ty);
+    let ty = ty.strip_suffix(" const").unwrap_or(ty);
+    ty.strip_prefix("std::").unwrap_or(ty)
+}
+
+fn is_integral(ty: &str) -> bool {
+    INTEGRAL_TYPES.contains(&base_type(ty))
+}
+
+/// Whether an integral parameter following a pointer is that pointer's length
+fn is_length_param(param: &HeaderParam) -> bool {
+    if !is_integral(&param.ty) {
+        return false;
+    }
+    if matches!(base_type(&param.ty), "size_t" | "ssize_t") {
+        return true;
+    }
+    let Some(name) = param.name.as_deref() else {
+        return false;
+    };
+    matches!(name, "n" | "len" | "length" | "size" | "count" | "num")
+        || ["max_", "num_", "n_"].iter().any(|p| name.starts_with(p))
+        || ["_len", "_length", "_size", "_count"]
+            .iter()
+            .any(|s| name.ends_with(s))
+}
+
+/// Harness variable for the parameter at `index`
+fn local_name(param: &HeaderParam, index: usize) -> String {
+    match param.name.as_deref() {
+        // Names the harness itself uses
+        Some(name @ ("data" | "size" | "fdp")) => format!("{name}_arg"),
+        Some(name) => name.to_string(),
+        None => format!("arg{index}"),
+    }
+}
+
+/// Picks how to draw each parameter; Err(reason) if one can't come from fuzz input
+fn plan_arguments(
+    function: &HeaderFunction,
+    object_types: &HashMap<String, String>,
+) -> Result<Vec<ArgPlan>, String> {
+    if function.params.is_empty() {
+        return Err("takes no arguments".to_string());
+    }
+
+    let mut plans = Vec::new();
+    let params = &function.params;
+    let mut i = 0;
+    while i < params.len() {
+        let param = &params[i];
+        let ty = param.ty.as_str();
+        let var = local_name(param, i);
+        // Converted arguments are named after the parameter plus a suffix
+        let raw_name = param.name.clone().unwrap_or_else(|| format!("arg{i}"));
+        let next = params.get(i + 1);
+
+        if ty.contains(['(', '[', '<']) || ty == "..." {
+            return Err(format!("unsupported parameter type '{ty}'"));
+        }
+        if is_integral(ty)
+            && param
+                .name
+                .as_deref()
+                .is_some_and(|n| n == "fd" || n.ends_with("_fd"))
+        {
+            return Err(format!(
+                "'{}' is a file descriptor",
+                param.name.as_deref().unwrap()
+            ));
+        }
+
+        if let Some(pointee) = ty.strip_suffix('*') {
+            let is_const = pointee.starts_with("const ") || pointee.ends_with(" const");
+            let elem = base_type(pointee);
+            let byte_like = BYTE_TYPES.contains(&elem) || (is_const && elem == "void");
+            let length = next.filter(|p| is_length_param(p));
+
+            if let (true, Some(length)) = (byte_like, length) {
+                plans.push(ArgPlan::Bytes {
+                    elem: if elem == "void" { "uint8_t" } else { elem }.to_string(),
+                    var: format!("{raw_name}_bytes"),
+                    size_ty: length.ty.clone(),
+                });
+                i += 2;
+                continue;
+            }
+            if elem == "char" && !is_const {
+                plans.push(ArgPlan::MutableString {
+                    var: format!("{raw_name}_buf"),
+                });
+            } else if elem == "char" {
+                plans.push(ArgPlan::String {
+                    var: format!("{raw_name}_str"),
+                    c_str: true,
+                });
+            } else if is_const {
+                return Err(format!("unsupported parameter type '{ty}'"));
+            } else if let (true, Some(length)) = (is_integral(elem), length) {
+                plans.push(ArgPlan::OutArray {
+                    elem: elem.to_string(),
+                    var,
+                    count_ty: base_type(&length.ty).to_string(),
+                    count_var: local_name(length, i + 1),
+                });
+                i += 2;
+                continue;
+            } else if is_integral(elem) || FLOATING_TYPES.contains(&elem) {
+                plans.push(ArgPlan::OutObject {
+                    ty: elem.to_string(),
+                    var,
+                });
+            } else if let Some(qualified) = object_types.get(elem) {
+                plans.push(ArgPlan::OutObject {
+                    ty: qualified.clone(),
+                    var,
+                });
+            } else {
+                return Err(format!("unsupported parameter type '{ty}'"));
+            }
+        } else if matches!(base_type(ty), "string" | "string&" | "string_view") {
+            plans.push(ArgPlan::String { var, c_str: false });
+        } else if ty.ends_with('&') {
+            return Err(format!("unsupported parameter type '{ty}'"));
+        } else if base_type(ty) == "bool" {
+            plans.push(ArgPlan::Scalar {
+                ty: "bool".to_string(),
+                var,
+                consume: "fdp.ConsumeBool()".to_string(),
+            });
+        } else if is_integral(ty) {
+            let ty = base_type(ty);
+            plans.push(ArgPlan::Scalar {
+                ty: ty.to_string(),
+                var,
+                consume: format!("fdp.ConsumeIntegral<{ty}>()"),
+            });
+        } else if FLOATING_TYPES.contains(&base_type(ty)) {
+            let ty = base_type(ty);
+            plans.push(ArgPlan::Scalar {
+                ty: ty.to_string(),
+                var,
+                consume: format!("fdp.ConsumeFloatingPoint<{ty}>()"),
+            });
+        } else {
+            return Err(format!("unsupported parameter type '{ty}'"));
+        }
+        i += 1;
+    }
+
+    Ok(plans)
+}
+
+fn render_function_harness(function: &HeaderFunction, signature: &str, args: &[ArgPlan]) -> String {
+    // Fixed-size arguments first: they come from the end of the input
+    let last_variable = args.iter().rposition(ArgPlan::is_variable_length);
+    let mut declarations = String::new();
+    for plan in args.iter().filter(|p| !p.is_variable_length()) {
+        declarations.push_str(&plan.declaration(false));
+    }
+    for (i, plan) in args.iter().enumerate() {
+        if plan.is_variable_length() {
+            declarations.push_str(&plan.declaration(Some(i) == last_variable));
+        }
+    }
+
+    let call_args: Vec<String> = args.iter().flat_map(ArgPlan::call_args).collect();
+    let call = format!("{}({})", function.name, call_args.join(", "));
+    let call = if function.return_type == "void" {
+        call
+    } else {
+        format!("(void){call}")
+    };
+
+    format!(
+        r#"// Generated by fuzz-init from {header}: fuzzes
+//   {signature}
+// directly, with each argument drawn from the input by FuzzedDataProvider.
+// Running fuzz-init --harness-per-function again overwrites this file.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fuzz_data_provider.h"
+#include "{header}"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {{
+    FuzzedDataProvider fdp(data, size);
+{declarations}
+    {call};
+    return 0;
+}}
+"#,
+        header = function.header,
+    )
+}
+
+/// Adds the harnesses to FUZZ_HARNESS_SRCS, above the "add more" marker line
+fn register_cmake_harnesses(cmake_lists: &Path, harnesses: &[String]) -> anyhow::Result<()> {
+    let content = fs::read_to_string(cmake_lists)?;
+    let Some(marker) = content.find(HARNESS_SRCS_MARKER) else {
+        anyhow::bail!(
+            "{} has no '{}' line in FUZZ_HARNESS_SRCS; add the generated harnesses there by hand",
+            cmake_lists.display(),
+            HARNESS_SRCS_MARKER
+        );
+    };
+    let line_start = content[..marker].rfind('\n').map_or(0, |i| i + 1);
+
+    const COMMENT: &str =
+        "  # One harness per header function (fuzz-init --harness-per-function)\n";
+    let mut lines: String = harnesses
+        .iter()
+        .map(|stem| format!("  \"${{FUZZ_SRC_DIR}}/{stem}.cpp\"\n"))
+        .filter(|line| !content.contains(line.as_str()))
+        .collect();
+    if lines.is_empty() {
+        return Ok(());
+    }
+    if !content.contains(COMMENT) {
+        lines.insert_str(0, COMMENT);
+    }
+
+    let updated = format!(
+        "{}{}{}",
+        &content[..line_start],
+        lines,
+        &content[line_start..]
+    );
+    fs::write(cmake_lists, updated)?;
+    Ok(())
+}
@@ -9,5 +9,27 @@ if(NOT AFL_CC OR NOT AFL_CXX)
 endif()
 set(CMAKE_C_COMPILER   ${AFL_CC}  CACHE STRING "" FORCE)
 set(CMAKE_CXX_COMPILER ${AFL_CXX} CACHE STRING "" FORCE)
-set(CMAKE_C_FLAGS_INIT   "-O1 -g -fno-omit-frame-pointer")
-set(CMAKE_CXX_FLAGS_INIT "-O1 -g -fno-omit-frame-pointer")
+set(CMAKE_C_FLAGS_INIT   "-O1 -g -fno-omit-frame-pointer -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+set(CMAKE_CXX_FLAGS_INIT "-O1 -g -fno-omit-frame-pointer -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+
+# Companion builds for the campaign (fuzz-afl-cmplog, fuzz-afl-laf) are named
+# <harness>-afl-cmplog / <harness>-afl-laf. Their instrumentation comes from
+# AFL_LLVM_CMPLOG / AFL_LLVM_LAF_ALL in the build preset's environment.
+set(FUZZ_AFL_VARIANT "" CACHE STRING "AFL++ companion build: cmplog, laf or empty")
+if(FUZZ_AFL_VARIANT)
+  set(FUZZER_TYPE "afl-${FUZZ_AFL_VARIANT}" CACHE STRING "Active fuzzer type" FORCE)
+endif()
+
+# fuzz-afl-fast: no ASan, -O2 (see fast.cmake)
+if(FUZZ_FAST)
+  include(${CMAKE_CURRENT_LIST_DIR}/fast.cmake)
+  set(CMAKE_C_FLAGS_INIT   "${FUZZ_FAST_FLAGS}")
+  set(CMAKE_CXX_FLAGS_INIT "${FUZZ_FAST_FLAGS}")
+endif()
+
+# A variant's instrumentation comes from the environment, which ccache doesn't
+# hash; naming it on the command line gives each variant its own cache entries
+if(FUZZ_AFL_VARIANT)
+  string(APPEND CMAKE_C_FLAGS_INIT   " -DFUZZ_AFL_VARIANT=${FUZZ_AFL_VARIANT}")
+  string(APPEND CMAKE_CXX_FLAGS_INIT " -DFUZZ_AFL_VARIANT=${FUZZ_AFL_VARIANT}")
+endif()
@@ -0,0 +1,17 @@
+# fuzz/cmake/ccache.cmake
+# Compiles through ccache when it's on PATH (-DFUZZ_CCACHE=OFF to disable).
+# CCACHE_BASEDIR makes the cache keys independent of where the project is
+# checked out, so build machines sharing a CCACHE_DIR reuse each other's
+# objects; set CCACHE_NOHASHDIR=1 as well to share -g objects across
+# checkouts. An explicit CMAKE_<LANG>_COMPILER_LAUNCHER wins.
+option(FUZZ_CCACHE "Compile through ccache when available" ON)
+
+if(FUZZ_CCACHE AND NOT CMAKE_CXX_COMPILER_LAUNCHER)
+  find_program(FUZZ_CCACHE_PROGRAM ccache)
+  if(FUZZ_CCACHE_PROGRAM)
+    set(_fuzz_launcher ${CMAKE_COMMAND} -E env CCACHE_BASEDIR=${CMAKE_SOURCE_DIR} ${FUZZ_CCACHE_PROGRAM})
+    set(CMAKE_C_COMPILER_LAUNCHER   ${_fuzz_launcher})
+    set(CMAKE_CXX_COMPILER_LAUNCHER ${_fuzz_launcher})
+    unset(_fuzz_launcher)
+  endif()
+endif()
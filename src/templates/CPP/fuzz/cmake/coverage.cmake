@@ -0,0 +1,18 @@
+# fuzz/toolchains/coverage.cmake
+# Standalone driver + harness with clang source-based coverage, for
+# `fuzz.sh coverage`. No sanitizers: the corpus only has to run, and what it
+# reaches is read back with llvm-profdata and llvm-cov.
+set(FUZZER_TYPE "coverage" CACHE STRING "Active fuzzer type" FORCE)
+set(CMAKE_BUILD_TYPE "Fuzzing" CACHE STRING "" FORCE)
+
+find_program(CLANG clang)
+find_program(CLANGXX clang++)
+if(NOT CLANG OR NOT CLANGXX)
+  message(FATAL_ERROR "clang/clang++ not found on PATH; -fprofile-instr-generate -fcoverage-mapping requires clang.")
+endif()
+set(CMAKE_C_COMPILER   ${CLANG}   CACHE STRING "" FORCE)
+set(CMAKE_CXX_COMPILER ${CLANGXX} CACHE STRING "" FORCE)
+
+# -O1 keeps the replay fast without folding away most of the regions
+set(CMAKE_C_FLAGS_INIT   "-O1 -g -fprofile-instr-generate -fcoverage-mapping -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+set(CMAKE_CXX_FLAGS_INIT "-O1 -g -fprofile-instr-generate -fcoverage-mapping -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
@@ -0,0 +1,49 @@
+# fuzz/toolchains/fast.cmake
+# High-throughput profile for the engine toolchains, enabled with
+# -DFUZZ_FAST=ON (the fuzz-<engine>-fast presets). No ASan and -O2, so long
+# campaigns run at full speed; their crashes and new corpus entries are then
+# replayed through the regular sanitizer build (./fuzz.sh run --fast).
+#
+#   FUZZ_FAST_UBSAN_TRAP (ON)  keep UBSan, trapping instead of reporting (no runtime)
+#   FUZZ_THINLTO (OFF)         build the library and harnesses with -flto=thin
+#   FUZZ_PGO_PROFILE ("")      optimize for this .profdata (-fprofile-use); see below
+set(FUZZER_TYPE "${FUZZER_TYPE}-fast" CACHE STRING "Active fuzzer type" FORCE)
+
+option(FUZZ_FAST_UBSAN_TRAP "Keep UBSan (trap mode) in the fast profile" ON)
+option(FUZZ_THINLTO "Build the fast profile with ThinLTO" OFF)
+
+set(FUZZ_FAST_FLAGS "-O2 -g -fno-omit-frame-pointer -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+if(FUZZ_FAST_UBSAN_TRAP)
+  string(APPEND FUZZ_FAST_FLAGS " -fsanitize=undefined -fsanitize-trap=undefined")
+endif()
+
+if(FUZZ_THINLTO)
+  # ThinLTO objects need an archiver and linker that understand LLVM bitcode
+  find_program(FUZZ_LLVM_AR llvm-ar)
+  find_program(FUZZ_LLVM_RANLIB llvm-ranlib)
+  find_program(FUZZ_LLD ld.lld)
+  if(NOT FUZZ_LLVM_AR OR NOT FUZZ_LLVM_RANLIB OR NOT FUZZ_LLD)
+    message(FATAL_ERROR "FUZZ_THINLTO needs llvm-ar, llvm-ranlib and ld.lld on PATH.")
+  endif()
+  set(CMAKE_AR     ${FUZZ_LLVM_AR}     CACHE FILEPATH "" FORCE)
+  set(CMAKE_RANLIB ${FUZZ_LLVM_RANLIB} CACHE FILEPATH "" FORCE)
+
+  string(APPEND FUZZ_FAST_FLAGS " -flto=thin")
+  set(CMAKE_EXE_LINKER_FLAGS_INIT "${CMAKE_EXE_LINKER_FLAGS_INIT} -flto=thin -fuse-ld=lld")
+endif()
+
+# Profile-guided optimization (./fuzz.sh build --pgo, the fuzz-all-pgo preset)
+# with a profile from replaying the corpus through the fuzz-coverage build.
+# It goes into the build type's flags rather than the _INIT ones so that it
+# also takes effect, or goes away, when an existing tree is reconfigured.
+set(FUZZ_PGO_PROFILE "" CACHE FILEPATH "Profile for -fprofile-use (from clang -fprofile-instr-generate)")
+set(_fuzz_pgo_flags "")
+if(FUZZ_PGO_PROFILE)
+  if(NOT EXISTS "${FUZZ_PGO_PROFILE}")
+    message(FATAL_ERROR "FUZZ_PGO_PROFILE ${FUZZ_PGO_PROFILE} does not exist; train it with ./fuzz.sh build --pgo.")
+  endif()
+  # Functions the corpus never ran (and the uninstrumented driver) have no profile
+  set(_fuzz_pgo_flags "-fprofile-use=${FUZZ_PGO_PROFILE} -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date")
+endif()
+set(CMAKE_C_FLAGS_FUZZING   "${_fuzz_pgo_flags}" CACHE STRING "" FORCE)
+set(CMAKE_CXX_FLAGS_FUZZING "${_fuzz_pgo_flags}" CACHE STRING "" FORCE)
@@ -9,5 +9,17 @@ if(NOT HF_CC OR NOT HF_CXX)
 endif()
 set(CMAKE_C_COMPILER   ${HF_CC}  CACHE STRING "" FORCE)
 set(CMAKE_CXX_COMPILER ${HF_CXX} CACHE STRING "" FORCE)
-set(CMAKE_C_FLAGS_INIT   "-O1 -g -fno-omit-frame-pointer")
-set(CMAKE_CXX_FLAGS_INIT "-O1 -g -fno-omit-frame-pointer")
+set(CMAKE_C_FLAGS_INIT   "-O1 -g -fno-omit-frame-pointer -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+set(CMAKE_CXX_FLAGS_INIT "-O1 -g -fno-omit-frame-pointer -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+
+# fuzz-honggfuzz-fast: no ASan, -O2 (see fast.cmake)
+if(FUZZ_FAST)
+  include(${CMAKE_CURRENT_LIST_DIR}/fast.cmake)
+  set(CMAKE_C_FLAGS_INIT   "${FUZZ_FAST_FLAGS}")
+  set(CMAKE_CXX_FLAGS_INIT "${FUZZ_FAST_FLAGS}")
+endif()
+
+# Fuzzing builds of the example library scan byte by byte for coverage
+# feedback; honggfuzz keeps the SIMD scan that release builds run.
+string(APPEND CMAKE_C_FLAGS_INIT   " -DMYLIB_VECTOR_SCAN=1")
+string(APPEND CMAKE_CXX_FLAGS_INIT " -DMYLIB_VECTOR_SCAN=1")
@@ -13,11 +13,20 @@ endif()
 set(CMAKE_C_COMPILER   ${CLANG}   CACHE STRING "" FORCE)
 set(CMAKE_CXX_COMPILER ${CLANGXX} CACHE STRING "" FORCE)
 
-set(FUZZ_SAN_SET "address,undefined")
-
-set(FUZZ_COMPILE_OPTS        "-fsanitize=fuzzer-no-link,${FUZZ_SAN_SET} -fno-omit-frame-pointer -g -O1")
-set(FUZZ_LINK_OPTS_WITH_MAIN "-fsanitize=fuzzer,${FUZZ_SAN_SET}")
-set(FUZZ_LINK_OPTS_NO_MAIN   "-fsanitize=${FUZZ_SAN_SET}")
+if(FUZZ_FAST)
+  # fuzz-libfuzzer-fast: no ASan, -O2 (see fast.cmake)
+  include(${CMAKE_CURRENT_LIST_DIR}/fast.cmake)
+
+  set(FUZZ_COMPILE_OPTS        "-fsanitize=fuzzer-no-link ${FUZZ_FAST_FLAGS}")
+  set(FUZZ_LINK_OPTS_WITH_MAIN "-fsanitize=fuzzer")
+  set(FUZZ_LINK_OPTS_NO_MAIN   "")
+else()
+  set(FUZZ_SAN_SET "address,undefined")
+
+  set(FUZZ_COMPILE_OPTS        "-fsanitize=fuzzer-no-link,${FUZZ_SAN_SET} -fno-omit-frame-pointer -g -O1 -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION")
+  set(FUZZ_LINK_OPTS_WITH_MAIN "-fsanitize=fuzzer,${FUZZ_SAN_SET}")
+  set(FUZZ_LINK_OPTS_NO_MAIN   "-fsanitize=${FUZZ_SAN_SET}")
+endif()
 
 # Apply compile opts globally
 set(CMAKE_C_FLAGS_INIT   "${CMAKE_C_FLAGS_INIT} ${FUZZ_COMPILE_OPTS}")
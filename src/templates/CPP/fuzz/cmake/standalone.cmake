@@ -4,3 +4,20 @@ set(CMAKE_BUILD_TYPE "Fuzzing" CACHE STRING "" FORCE)
 
 set(CMAKE_C_FLAGS_INIT   "-O2 -g -fno-omit-frame-pointer")
 set(CMAKE_CXX_FLAGS_INIT "-O2 -g -fno-omit-frame-pointer")
+
+# -DFUZZ_TRACE_PC_GUARD=ON (the fuzz-standalone-cov preset) adds edge
+# coverage, which the driver collects for -minimize_corpus. Needs clang.
+if(FUZZ_TRACE_PC_GUARD)
+  set(FUZZER_TYPE "native-cov" CACHE STRING "Active fuzzer type" FORCE)
+
+  find_program(CLANG clang)
+  find_program(CLANGXX clang++)
+  if(NOT CLANG OR NOT CLANGXX)
+    message(FATAL_ERROR "clang/clang++ not found on PATH; -fsanitize-coverage=trace-pc-guard requires clang.")
+  endif()
+  set(CMAKE_C_COMPILER   ${CLANG}   CACHE STRING "" FORCE)
+  set(CMAKE_CXX_COMPILER ${CLANGXX} CACHE STRING "" FORCE)
+
+  set(CMAKE_C_FLAGS_INIT   "${CMAKE_C_FLAGS_INIT} -fsanitize-coverage=trace-pc-guard -DFUZZ_TRACE_PC_GUARD=1")
+  set(CMAKE_CXX_FLAGS_INIT "${CMAKE_CXX_FLAGS_INIT} -fsanitize-coverage=trace-pc-guard -DFUZZ_TRACE_PC_GUARD=1")
+endif()
@@ -0,0 +1,82 @@
+# fuzz/cmake/superbuild.cmake
+# -DFUZZ_SUPERBUILD=ON (the fuzz-all / fuzz-all-fast presets): instead of
+# building anything itself, the project drives every engine's regular tree
+# (build/<engine>, configured from its fuzz-<engine> preset) as an external
+# project. All trees configure and build at the same time, and with a
+# Makefile generator they share the top-level make's job server, so -jN
+# bounds the whole build rather than each engine. Engines whose compiler
+# isn't on PATH are skipped.
+#
+#   FUZZ_FAST (OFF)     build the fuzz-<engine>-fast trees instead
+#   FUZZ_THINLTO (OFF)  passed on to the fast trees
+#   FUZZ_PGO_PROFILE    passed on to the fast trees (fuzz-all-pgo)
+include(ExternalProject)
+
+option(FUZZ_FAST "Superbuild the fast profile trees" OFF)
+option(FUZZ_THINLTO "Build the fast profile trees with ThinLTO" OFF)
+set(FUZZ_PGO_PROFILE "" CACHE FILEPATH "Profile for -fprofile-use in the fast profile trees")
+
+set(_suffix "")
+set(_extra_args "")
+if(FUZZ_FAST)
+  set(_suffix "-fast")
+  list(APPEND _extra_args -DFUZZ_THINLTO=${FUZZ_THINLTO} -DFUZZ_PGO_PROFILE=${FUZZ_PGO_PROFILE})
+endif()
+
+# Environment of the fuzz-<engine> build presets (used for compiling and linking)
+set(_asan_env AFL_USE_ASAN=1 AFL_USE_UBSAN=1)
+if(FUZZ_FAST)
+  set(_asan_env "")
+endif()
+
+set(_engines libfuzzer afl afl-cmplog afl-laf honggfuzz)
+set(_tool_libfuzzer  clang++)
+set(_tool_afl        afl-clang-fast++)
+set(_tool_afl-cmplog afl-clang-fast++)
+set(_tool_afl-laf    afl-clang-fast++)
+set(_tool_honggfuzz  hfuzz-clang++)
+set(_env_libfuzzer   "")
+set(_env_afl         ${_asan_env})
+set(_env_afl-cmplog  ${_asan_env} AFL_LLVM_CMPLOG=1)
+set(_env_afl-laf     ${_asan_env} AFL_LLVM_LAF_ALL=1)
+set(_env_honggfuzz   "")
+# The standalone build has no sanitizers, so it has no fast profile
+if(NOT FUZZ_FAST)
+  list(APPEND _engines standalone)
+  set(_tool_standalone ${CMAKE_CXX_COMPILER})
+  set(_env_standalone  "")
+endif()
+
+# $(MAKE) makes each engine's make a sub-make of the top-level one
+if(CMAKE_GENERATOR MATCHES "Make")
+  set(_make "$(MAKE)")
+else()
+  set(_make ${CMAKE_COMMAND} --build .)
+endif()
+
+foreach(engine ${_engines})
+  set(preset "fuzz-${engine}${_suffix}")
+  find_program(_tool_path_${engine} ${_tool_${engine}})
+  if(NOT _tool_path_${engine})
+    message(STATUS "Skipping ${preset}: ${_tool_${engine}} not found")
+    continue()
+  endif()
+
+  if(_env_${engine})
+    set(build_command ${CMAKE_COMMAND} -E env ${_env_${engine}} ${_make})
+  else()
+    set(build_command ${_make})
+  endif()
+
+  ExternalProject_Add(${preset}
+    SOURCE_DIR        ${CMAKE_SOURCE_DIR}
+    BINARY_DIR        ${CMAKE_SOURCE_DIR}/build/${engine}${_suffix}
+    CONFIGURE_COMMAND ${CMAKE_COMMAND} -S <SOURCE_DIR> -G ${CMAKE_GENERATOR}
+                      --preset ${preset} ${_extra_args}
+    BUILD_COMMAND     ${build_command}
+    INSTALL_COMMAND   ""
+    # Each tree tracks its own dependencies, so always let it decide
+    BUILD_ALWAYS      ON
+  )
+  message(STATUS "Superbuild: ${preset} -> build/${engine}${_suffix}")
+endforeach()
@@ -0,0 +1,17 @@
+# fuzz/toolchains/tsan.cmake
+# Standalone driver + harness under ThreadSanitizer, for -threads=N stress runs.
+set(FUZZER_TYPE "tsan" CACHE STRING "Active fuzzer type" FORCE)
+set(CMAKE_BUILD_TYPE "Fuzzing" CACHE STRING "" FORCE)
+
+# Prefer clang; GCC's -fsanitize=thread works too.
+find_program(CLANG clang)
+find_program(CLANGXX clang++)
+if(CLANG AND CLANGXX)
+  set(CMAKE_C_COMPILER   ${CLANG}   CACHE STRING "" FORCE)
+  set(CMAKE_CXX_COMPILER ${CLANGXX} CACHE STRING "" FORCE)
+endif()
+
+# No FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION: races are looked for in the
+# production code paths.
+set(CMAKE_C_FLAGS_INIT   "-fsanitize=thread -O1 -g -fno-omit-frame-pointer")
+set(CMAKE_CXX_FLAGS_INIT "-fsanitize=thread -O1 -g -fno-omit-frame-pointer")
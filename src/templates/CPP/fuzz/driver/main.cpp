@@ -4,25 +4,40 @@
 //   extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
 //
 // It mirrors the common afl_driver semantics while keeping sanitizer calls optional.
+// When built with afl-clang-fast and run without input paths, it uses AFL++
+// persistent mode with deferred init and shared-memory testcases.
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 #include <string_view>
 #include <sys/stat.h>
 
 #if defined(_WIN32)
 
+#include <direct.h>
 #include <io.h>
 // makes windows low-level IO posix-compatible
 #define open _open
 #define read _read
+#define write _write
 #define stat _stat
 #define fileno _fileno
 #define close _close
@@ -35,12 +50,33 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#endif
+#if defined(__linux__)
+#include <link.h>
+#endif
+#if defined(__GLIBC__)
+#include <execinfo.h>
 #endif
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
 extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) __attribute__((weak));
 
+// ---------- AFL++ persistent mode ----------
+// afl-clang-fast defines these macros. __AFL_FUZZ_INIT() sets up the shared
+// memory testcase buffer so afl-fuzz can hand us inputs without a file or a
+// read() per exec; it must appear at file scope.
+#if defined(__AFL_FUZZ_TESTCASE_LEN) && defined(__AFL_HAVE_MANUAL_CONTROL)
+#  define FUZZ_AFL_PERSISTENT 1
+__AFL_FUZZ_INIT();
+#endif
+
 // ---------- Detect sanitizers (for optional hooks) ----------
 #ifndef FUZZ_HAS_SANITIZER
 #  if defined(__has_feature)
@@ -55,12 +91,42 @@ extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) __attribute__((weak
 #  endif
 #endif
 
+#ifndef FUZZ_HAS_ASAN
+#  if defined(__has_feature)
+#    if __has_feature(address_sanitizer)
+#      define FUZZ_HAS_ASAN 1
+#    endif
+#  endif
+#  if !defined(FUZZ_HAS_ASAN) && defined(__SANITIZE_ADDRESS__)
+#    define FUZZ_HAS_ASAN 1
+#  endif
+#endif
+
+#if FUZZ_HAS_ASAN
+extern "C" void __asan_poison_memory_region(void const volatile*, size_t) __attribute__((weak));
+extern "C" void __asan_unpoison_memory_region(void const volatile*, size_t) __attribute__((weak));
+#endif
+
+#ifndef FUZZ_HAS_ALLOCATOR_SANITIZER
+#  if defined(__has_feature)
+#    if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#      define FUZZ_HAS_ALLOCATOR_SANITIZER 1
+#    endif
+#  endif
+#  if !defined(FUZZ_HAS_ALLOCATOR_SANITIZER) && (defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__))
+#    define FUZZ_HAS_ALLOCATOR_SANITIZER 1
+#  endif
+#endif
+
 #if FUZZ_HAS_SANITIZER
 #  include <sanitizer/common_interface_defs.h>
 // Keep sanitizer symbols optional so native link won’t fail.
 extern "C" void __sanitizer_set_report_fd(void*) __attribute__((weak));
 extern "C" void __sanitizer_set_report_path(const char*) __attribute__((weak));
 extern "C" void __sanitizer_set_death_callback(void (*)()) __attribute__((weak));
+extern "C" void __sanitizer_print_stack_trace() __attribute__((weak));
+extern "C" int __sanitizer_install_malloc_and_free_hooks(
+    void (*)(const volatile void*, size_t), void (*)(const volatile void*)) __attribute__((weak));
 #endif
 
 // -------------------- Utils --------------------
@@ -74,137 +140,2881 @@ static bool is_file(const char* p) {
   return stat(p, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG;
 }
 
-static void list_files_in_dir(const char* dir, std::vector<std::string>& out) {
+// Walks root depth-first without recursion, calling emit(path) for each
+// regular file (following symlinks, skipping dot files) until it returns
+// false. Entry types come from d_type; only entries it can't classify
+// (DT_UNKNOWN on some filesystems, symlinks) cost an fstatat(). Returns
+// false if emit stopped the walk.
+template <typename Emit>
+static bool walk_dir(const std::string& root, Emit&& emit) {
 #if defined(_WIN32)
   // Minimal Windows handling omitted for brevity; native Linux is the common case.
-  (void)dir; (void)out;
-#else
-  DIR* d = opendir(dir);
-  if (!d) return;
-  while (auto* ent = readdir(d)) {
-    if (ent->d_name[0] == '.') continue;
-    std::string path = std::string(dir) + "/" + ent->d_name;
-    if (is_file(path.c_str())) {
-      out.push_back(path);
-    } else {
-      list_files_in_dir(path.c_str(), out);
+  (void)root; (void)emit;
+  return true;
+#else
+  std::vector<std::string> pending{root};
+  std::vector<std::string> subdirs;
+  std::string path;
+  while (!pending.empty()) {
+    std::string dir = std::move(pending.back());
+    pending.pop_back();
+    DIR* d = opendir(dir.c_str());
+    if (!d) continue;
+    path.assign(dir).push_back('/');
+    const size_t base = path.size();
+    subdirs.clear();
+    while (auto* ent = readdir(d)) {
+      if (ent->d_name[0] == '.') continue;
+      bool file = ent->d_type == DT_REG;
+      bool sub = ent->d_type == DT_DIR;
+      if (ent->d_type == DT_UNKNOWN || ent->d_type == DT_LNK) {
+        struct stat st;
+        if (fstatat(dirfd(d), ent->d_name, &st, 0) != 0) continue;
+        file = S_ISREG(st.st_mode);
+        sub = S_ISDIR(st.st_mode);
+      }
+      path.resize(base);
+      path += ent->d_name;
+      if (file && !emit(path)) {
+        closedir(d);
+        return false;
+      }
+      if (sub) subdirs.push_back(path);
     }
+    closedir(d);
+    // Visit subdirectories in readdir order.
+    pending.insert(pending.end(), std::make_move_iterator(subdirs.rbegin()),
+                   std::make_move_iterator(subdirs.rend()));
   }
-  closedir(d);
+  return true;
+#endif
+}
+
+// -------------------- Input loading --------------------
+// Inputs reach the harness without a copy: large regular files are mapped
+// read-only, everything else is read into one buffer that is reused across
+// inputs and only grows to the largest input seen. Under ASan the bytes past
+// the end of each input are poisoned so overreads are still reported.
+static const size_t kMmapThreshold = 64 * 1024;
+
+// One input to replay: a file, or an entry of a mapped corpus pack (data is
+// set and path only names it in reports). For files, size is only filled in
+// when -sort_by_size needs it.
+struct Input {
+  std::string path;
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+};
+
+static void poison_region(const void* p, size_t n) {
+#if FUZZ_HAS_ASAN
+  if (n && __asan_poison_memory_region) __asan_poison_memory_region(p, n);
+#else
+  (void)p; (void)n;
+#endif
+}
+
+static void unpoison_region(const void* p, size_t n) {
+#if FUZZ_HAS_ASAN
+  if (n && __asan_unpoison_memory_region) __asan_unpoison_memory_region(p, n);
+#else
+  (void)p; (void)n;
 #endif
 }
 
-static uint8_t *read_data(int fd, size_t *len, size_t max_len) {
-  uint8_t *ptr = NULL;
-  *len = 0;
-  while (*len <= max_len) {
-    uint8_t buf[BUFSIZ];
-    int n = read(fd, buf, sizeof(buf));
-    if (n == -1) {
-      std::perror("read");
-      std::exit(1);
+class InputLoader {
+ public:
+  InputLoader() = default;
+  InputLoader(const InputLoader&) = delete;
+  InputLoader& operator=(const InputLoader&) = delete;
+  ~InputLoader() {
+    release();
+    std::free(buf_);
+  }
+
+  // Loads at most max_len bytes of path. Returns false if it can't be read.
+  bool load_file(const char* path, size_t max_len) {
+    release();
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+      fprintf(stderr, "can't open file %s: %s\n", path, strerror(errno));
+      return false;
     }
-    if (n == 0) {
-      break;
+    struct stat st;
+    bool ok = true;
+    if (fstat(fd, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG) {
+      size_t want = std::min<size_t>(static_cast<size_t>(st.st_size), max_len);
+      ok = (want >= kMmapThreshold && map_fd(fd, want)) || read_fd(fd, want, want);
+    } else {
+      ok = read_fd(fd, 0, max_len);
+    }
+    close(fd);
+    return ok;
+  }
+
+  // Loads at most max_len bytes of in. Pack entries are used in place; their
+  // bytes are only unpoisoned while loaded.
+  bool load(const Input& in, size_t max_len) {
+    if (!in.data) return load_file(in.path.c_str(), max_len);
+    release();
+    data_ = in.data;
+    size_ = std::min(in.size, max_len);
+    borrowed_ = true;
+    unpoison(data_, size_);
+    return true;
+  }
+
+  // Reads fd (e.g. a pipe) to EOF, keeping at most max_len bytes.
+  bool load_fd(int fd, size_t max_len) {
+    release();
+    return read_fd(fd, 0, max_len);
+  }
+
+  // Drops the current input; unmaps it if it was mapped.
+  void release() {
+    if (borrowed_) {
+      poison(data_, size_);
+      borrowed_ = false;
+    }
+#if !defined(_WIN32)
+    if (map_) {
+      unpoison(map_, map_len_);
+      munmap(map_, map_len_);
+      map_ = nullptr;
+      map_len_ = 0;
+    }
+#endif
+    if (buf_) unpoison(buf_, cap_);
+    data_ = buf_;
+    size_ = 0;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  bool map_fd(int fd, size_t len) {
+#if defined(_WIN32)
+    (void)fd; (void)len;
+    return false;
+#else
+    void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return false;
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    map_ = p;
+    map_len_ = (len + page - 1) / page * page;
+    data_ = static_cast<const uint8_t*>(p);
+    size_ = len;
+    poison(static_cast<uint8_t*>(p) + len, map_len_ - len);
+    return true;
+#endif
+  }
+
+  // Reads until EOF or max_len bytes. `hint` pre-sizes the buffer when the
+  // file size is known so regular files need a single read().
+  bool read_fd(int fd, size_t hint, size_t max_len) {
+    size_t len = 0;
+    if (!reserve(std::max<size_t>(hint, 1))) return false;
+    while (len < max_len) {
+      if (len == cap_ && !reserve(std::min(max_len, std::max<size_t>(cap_ * 2, 64 * 1024)))) {
+        return false;
+      }
+      ssize_t n = read(fd, buf_ + len, std::min(cap_, max_len) - len);
+      if (n == -1) {
+        if (errno == EINTR) continue;
+        std::perror("read");
+        return false;
+      }
+      if (n == 0) break;
+      len += static_cast<size_t>(n);
     }
+    data_ = buf_;
+    size_ = len;
+    poison(buf_ + len, cap_ - len);
+    return true;
+  }
 
-    n = std::min<int>(n, max_len - *len);
-    *len += n;
-    ptr = (uint8_t *)realloc(ptr, *len);
-    if (ptr == NULL) {
+  bool reserve(size_t n) {
+    if (n <= cap_) return true;
+    uint8_t* p = static_cast<uint8_t*>(std::realloc(buf_, n));
+    if (p == nullptr) {
       std::perror("realloc");
-      std::exit(1);
+      return false;
     }
-    std::memcpy(ptr + *len - n, buf, n);
+    buf_ = p;
+    cap_ = n;
+    data_ = buf_;
+    return true;
   }
-  return ptr;
+
+  static void poison(const void* p, size_t n) { poison_region(p, n); }
+  static void unpoison(const void* p, size_t n) { unpoison_region(p, n); }
+
+  uint8_t* buf_ = nullptr;
+  size_t cap_ = 0;
+  void* map_ = nullptr;
+  size_t map_len_ = 0;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool borrowed_ = false;
+};
+
+// -------------------- Corpus packs (-pack=OUT) --------------------
+// A pack holds a whole corpus in one file so replaying it costs one open and
+// one mmap instead of a stat/open/read/close per input. Integers are
+// little-endian and offsets are from the start of the file:
+//   header  "FUZZPACK", u32 version (1), u32 reserved (0), u64 entry count
+//   index   per entry: u64 data offset, u64 data size, u64 name offset, u64 name size
+//   names   entry names (paths relative to the packed directory), concatenated
+//   data    the inputs, each starting on a 16-byte boundary
+// Entries are sorted by name and all padding is zero, so packing the same
+// corpus twice gives identical bytes.
+static const char kPackMagic[8] = {'F', 'U', 'Z', 'Z', 'P', 'A', 'C', 'K'};
+static const uint32_t kPackVersion = 1;
+static const size_t kPackHeaderSize = 24;
+static const size_t kPackIndexEntrySize = 32;
+static const size_t kPackAlign = 16;
+
+static void put_le(uint8_t* p, uint64_t v, size_t n) {
+  for (size_t i = 0; i < n; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t* p, size_t n) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < n; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+  return v;
 }
 
-static uint8_t *read_file(const char* path, size_t *len, size_t max_len) {
+static size_t pack_align(size_t n) { return (n + kPackAlign - 1) / kPackAlign * kPackAlign; }
+
+static bool is_pack(const char* path) {
   int fd = open(path, O_RDONLY);
-  if (fd == -1) {
-    fprintf(stderr, "can't open file %s: %s\n", path, strerror(errno));
-    return NULL;
-  }
-  uint8_t *data = read_data(fd, len, max_len);
+  if (fd == -1) return false;
+  char magic[sizeof(kPackMagic)];
+  bool ok = read(fd, magic, sizeof(magic)) == static_cast<ssize_t>(sizeof(magic)) &&
+            std::memcmp(magic, kPackMagic, sizeof(magic)) == 0;
   close(fd);
-  return data;
+  return ok;
 }
 
-// Optional: ensure sanitizer reports get flushed
-#if FUZZ_HAS_SANITIZER
-static void on_sanitizer_death() { std::fflush(nullptr); }
+// A mapped pack. Entries point into the mapping, so it must outlive them.
+class CorpusPack {
+ public:
+  CorpusPack() = default;
+  CorpusPack(const CorpusPack&) = delete;
+  CorpusPack& operator=(const CorpusPack&) = delete;
+  ~CorpusPack() {
+    if (!base_) return;
+    unpoison_region(base_, len_);
+#if defined(_WIN32)
+    std::free(base_);
+#else
+    munmap(base_, len_);
 #endif
+  }
 
-// -------------------- Driver --------------------
-int main(int argc, char** argv) {
-  // Parse simple flags we support (like afl_driver):
-  //   -runs=N     limit number of testcase invocations
-  // Everything else is treated as a path (file or directory).
-  int runs = -1;
-  std::vector<std::string> paths;
-  for (int i = 1; i < argc; ++i) {
-    if (std::strncmp(argv[i], "-runs=", 6) == 0) {
-      runs = std::atoi(argv[i] + 6);
-    } else {
-      paths.emplace_back(argv[i]);
+  // Maps path and appends its entries to out, named "path:name". Under ASan
+  // the whole pack is poisoned; InputLoader::load unpoisons one entry at a
+  // time, so reads past an entry are reported like for any other input.
+  bool open(const char* path, std::vector<Input>& out) {
+    if (!map(path)) {
+      fprintf(stderr, "can't read pack %s: %s\n", path, strerror(errno));
+      return false;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(base_);
+    uint64_t count = size_ >= kPackHeaderSize ? get_le(p + 16, 8) : 0;
+    if (size_ < kPackHeaderSize || std::memcmp(p, kPackMagic, sizeof(kPackMagic)) != 0 ||
+        get_le(p + 8, 4) != kPackVersion || count > (size_ - kPackHeaderSize) / kPackIndexEntrySize) {
+      fprintf(stderr, "%s: truncated or not a version %u corpus pack\n", path, kPackVersion);
+      return false;
     }
+    auto in_bounds = [&](uint64_t off, uint64_t len) { return off <= size_ && len <= size_ - off; };
+    std::vector<Input> entries;
+    entries.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i) {
+      const uint8_t* e = p + kPackHeaderSize + i * kPackIndexEntrySize;
+      uint64_t data_off = get_le(e, 8), data_len = get_le(e + 8, 8);
+      uint64_t name_off = get_le(e + 16, 8), name_len = get_le(e + 24, 8);
+      if (!in_bounds(data_off, data_len) || !in_bounds(name_off, name_len)) {
+        fprintf(stderr, "%s: entry %llu is out of bounds\n", path, static_cast<unsigned long long>(i));
+        return false;
+      }
+      Input in;
+      in.path = std::string(path) + ":" +
+                std::string(reinterpret_cast<const char*>(p + name_off), static_cast<size_t>(name_len));
+      in.data = p + data_off;
+      in.size = static_cast<size_t>(data_len);
+      entries.push_back(std::move(in));
+    }
+    poison_region(base_, len_);
+    out.insert(out.end(), entries.begin(), entries.end());
+    return true;
   }
 
-  // Environment knobs
-  size_t max_len = 1 << 20; // 1 MiB default
-  if (const char* ml = std::getenv("AFL_DRIVER_MAX_LEN")) {
-    long v = std::strtol(ml, nullptr, 10);
-    if (v > 0) max_len = static_cast<size_t>(v);
+ private:
+  bool map(const char* path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    size_ = ok ? static_cast<size_t>(st.st_size) : 0;
+#if defined(_WIN32)
+    // No mmap: read the pack into one allocation.
+    base_ = ok ? std::malloc(std::max<size_t>(size_, 1)) : nullptr;
+    len_ = size_;
+    for (size_t got = 0; base_ && got < size_;) {
+      int n = read(fd, static_cast<uint8_t*>(base_) + got, static_cast<unsigned>(size_ - got));
+      if (n <= 0) {
+        ok = false;
+        break;
+      }
+      got += static_cast<size_t>(n);
+    }
+    ok = ok && base_;
+#else
+    if (ok && size_ > 0) {
+      void* m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      ok = m != MAP_FAILED;
+      if (ok) {
+        static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        base_ = m;
+        len_ = (size_ + page - 1) / page * page;
+        // Inputs are replayed in order; let the kernel read ahead.
+        madvise(m, size_, MADV_SEQUENTIAL);
+      }
+    }
+#endif
+    close(fd);
+    return ok;
   }
 
-#if FUZZ_HAS_SANITIZER
-  // Duplicate sanitizer reports to file if requested (compatible with afl_driver)
-  if (const char* dup = std::getenv("AFL_DRIVER_STDERR_DUPLICATE_FILENAME")) {
-    if (__sanitizer_set_report_path) __sanitizer_set_report_path(dup);
+  void* base_ = nullptr;
+  size_t len_ = 0;   // mapped length (whole pages)
+  size_t size_ = 0;  // file size
+};
+
+// Writes the inputs under paths (files, directories, or other packs) to a
+// new pack at out_path. Returns the process exit code.
+static int write_pack(const std::vector<std::string>& paths, const std::string& out_path) {
+  struct Member {
+    std::string name;
+    Input input;
+  };
+  std::vector<Member> members;
+  std::vector<std::unique_ptr<CorpusPack>> packs;
+  for (const auto& p : paths) {
+    if (is_dir(p.c_str())) {
+      walk_dir(p, [&](const std::string& f) {
+        members.push_back({f.substr(p.size() + 1), Input{f}});
+        return true;
+      });
+    } else if (is_file(p.c_str()) && is_pack(p.c_str())) {
+      std::vector<Input> entries;
+      packs.emplace_back(new CorpusPack());
+      if (!packs.back()->open(p.c_str(), entries)) return 1;
+      for (auto& e : entries) members.push_back({e.path.substr(p.size() + 1), e});
+    } else if (is_file(p.c_str())) {
+      members.push_back({p, Input{p}});
+    }
   }
-  if (__sanitizer_set_death_callback) __sanitizer_set_death_callback(&on_sanitizer_death);
-  // Prefer fd routing if available
-  if (__sanitizer_set_report_fd) {
-    __sanitizer_set_report_fd(reinterpret_cast<void*>(fileno(stderr)));
+  std::stable_sort(members.begin(), members.end(),
+                   [](const Member& a, const Member& b) { return a.name < b.name; });
+
+  size_t names_len = 0;
+  for (const auto& m : members) names_len += m.name.size();
+  size_t names_off = kPackHeaderSize + members.size() * kPackIndexEntrySize;
+  std::vector<uint8_t> head(pack_align(names_off + names_len), 0);
+  std::memcpy(head.data(), kPackMagic, sizeof(kPackMagic));
+  put_le(&head[8], kPackVersion, 4);
+  put_le(&head[16], members.size(), 8);
+
+  std::string tmp_path = out_path + ".tmp";
+  FILE* out = std::fopen(tmp_path.c_str(), "wb");
+  if (!out) {
+    fprintf(stderr, "can't write %s: %s\n", tmp_path.c_str(), strerror(errno));
+    return 1;
   }
+  // Data first (at its final offset), then the header once sizes are known.
+  static const uint8_t zeros[kPackAlign] = {};
+  bool ok = std::fseek(out, static_cast<long>(head.size()), SEEK_SET) == 0;
+  size_t off = head.size(), name_off = names_off, total = 0;
+  InputLoader loader;
+  for (size_t i = 0; ok && i < members.size(); ++i) {
+    const Member& m = members[i];
+    if (!loader.load(m.input, SIZE_MAX)) {
+      ok = false;
+      break;
+    }
+    size_t pad = pack_align(loader.size()) - loader.size();
+    ok = std::fwrite(loader.data(), 1, loader.size(), out) == loader.size() &&
+         std::fwrite(zeros, 1, pad, out) == pad;
+    uint8_t* e = &head[kPackHeaderSize + i * kPackIndexEntrySize];
+    put_le(e, off, 8);
+    put_le(e + 8, loader.size(), 8);
+    put_le(e + 16, name_off, 8);
+    put_le(e + 24, m.name.size(), 8);
+    std::memcpy(&head[name_off], m.name.data(), m.name.size());
+    off += loader.size() + pad;
+    name_off += m.name.size();
+    total += loader.size();
+    loader.release();
+  }
+  ok = ok && std::fseek(out, 0, SEEK_SET) == 0 &&
+       std::fwrite(head.data(), 1, head.size(), out) == head.size();
+  ok = (std::fclose(out) == 0) && ok;
+#if defined(_WIN32)
+  std::remove(out_path.c_str());  // rename() doesn't replace on Windows
 #endif
-
-  // Allow user harness init
-  if (LLVMFuzzerInitialize) {
-    (void)LLVMFuzzerInitialize(&argc, &argv);
+  if (!ok || std::rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+    fprintf(stderr, "can't write %s: %s\n", out_path.c_str(), strerror(errno));
+    std::remove(tmp_path.c_str());
+    return 1;
   }
+  fprintf(stderr, "==driver== packed %zu inputs (%zu bytes) into %s\n", members.size(), total,
+          out_path.c_str());
+  return 0;
+}
 
-  // Build list of inputs: files from args (expanding directories), or stdin if none.
-  std::vector<std::string> files;
+// -------------------- Input enumeration --------------------
+// Inputs come from the command line in order: directories are walked, packs
+// are expanded and files are taken as they are. Plain serial replay runs
+// while the walk continues: a walker thread feeds a bounded queue, so deep
+// corpora start executing right away. Modes that need the whole list up
+// front (-jobs, -keep_going, -bench, -threads, -minimize_corpus,
+// -corpus_stats, -dedup, -sort_by_size) collect it first.
+static const size_t kInputQueueDepth = 1024;
+
+// Calls emit(Input&&) for every input under paths until it returns false or
+// max_files inputs were produced (0 = no limit). Packs are kept alive in
+// packs. Returns false if a pack can't be read.
+template <typename Emit>
+static bool collect_inputs(const std::vector<std::string>& paths, size_t max_files,
+                           std::vector<std::unique_ptr<CorpusPack>>& packs, Emit&& emit) {
+  size_t n = 0;
+  bool more = true;
+  auto add = [&](Input&& in) {
+    more = emit(std::move(in)) && (max_files == 0 || ++n < max_files);
+    return more;
+  };
   for (const auto& p : paths) {
+    if (!more) break;
     if (p == "@@" || p == "___FILE___") continue; // wrappers should substitute these
-    if (is_dir(p.c_str())) list_files_in_dir(p.c_str(), files);
-    else if (is_file(p.c_str())) files.push_back(p);
+    if (is_dir(p.c_str())) {
+      walk_dir(p, [&](const std::string& f) { return add(Input{f}); });
+    } else if (is_file(p.c_str()) && is_pack(p.c_str())) {
+      std::vector<Input> entries;
+      packs.emplace_back(new CorpusPack());
+      if (!packs.back()->open(p.c_str(), entries)) return false;
+      for (auto& e : entries) {
+        if (!add(std::move(e))) break;
+      }
+    } else if (is_file(p.c_str())) {
+      add(Input{p});
+    }
   }
+  return true;
+}
 
-  size_t len;
-  // No inputs? Read stdin once.
-  if (files.empty()) {
-    uint8_t *data = read_data(0, &len, max_len);
-    LLVMFuzzerTestOneInput(data, len);
-    free(data);
-    return 0;
+// Bounded queue from the walker thread to the replay loop.
+class InputQueue {
+ public:
+  explicit InputQueue(size_t depth) : depth_(depth) {}
+
+  // Blocks while the queue is full. Returns false once the consumer stopped.
+  bool push(Input&& in) {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_full_.wait(lock, [&] { return items_.size() < depth_ || stopped_; });
+    if (stopped_) return false;
+    items_.push_back(std::move(in));
+    not_empty_.notify_one();
+    return true;
   }
 
-  int executed = 0;
-  for (const auto& f : files) {
-    if (runs >= 0 && executed >= runs) {
-      break;
+  // Blocks while the queue is empty. Returns false once the producer is done
+  // and everything was consumed.
+  bool pop(Input& in) {
+    std::unique_lock<std::mutex> lock(mu_);
+    not_empty_.wait(lock, [&] { return !items_.empty() || done_; });
+    if (items_.empty()) return false;
+    in = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  // Producer side: no more inputs.
+  void finish() {
+    std::lock_guard<std::mutex> lock(mu_);
+    done_ = true;
+    not_empty_.notify_all();
+  }
+
+  // Consumer side: stop the producer early.
+  void stop() {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopped_ = true;
+    not_full_.notify_all();
+  }
+
+ private:
+  const size_t depth_;
+  std::deque<Input> items_;
+  std::mutex mu_;
+  std::condition_variable not_empty_, not_full_;
+  bool done_ = false, stopped_ = false;
+};
+
+// -------------------- Replay cache (-replay_cache=DIR) --------------------
+// Remembers which inputs already passed against this exact binary, so CI runs
+// over an unchanged corpus skip them. DIR holds one file per binary, named
+// after its ELF build-id (or a hash of the executable if it has none) and a
+// hash of the build-ids of the shared libraries it loaded, so rebuilding one
+// of those starts a new file. The name also carries a hash of the settings
+// that decide whether an input passes: -timeout, -rss_limit_mb,
+// -malloc_limit_mb, AFL_DRIVER_MAX_LEN and the sanitizer *_OPTIONS, so
+// tightening a limit runs everything again. The file lists the content hash
+// of every input that ran without crashing or timing out.
+// Passes are appended as they happen through an O_APPEND descriptor, so forked
+// workers share it and a crash part-way through keeps everything before it.
+// Inputs that only crash after some other input ran can be masked once that
+// other input is cached; -force=1 (or --force) runs everything again.
+// Other environment the harness itself reads is not part of the key.
+
+// 64-bit FNV-1a, seeded with the size.
+static uint64_t input_hash(const uint8_t* data, size_t size) {
+  uint64_t h = 0xcbf29ce484222325ULL ^ static_cast<uint64_t>(size);
+  for (size_t i = 0; i < size; ++i) {
+    h ^= data[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// Hash of a whole file as "file-<hash>", or "" if it can't be read.
+static std::string file_id(const char* path) {
+  InputLoader loader;
+  if (!loader.load_file(path, SIZE_MAX)) return "";
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "file-%016llx",
+                static_cast<unsigned long long>(input_hash(loader.data(), loader.size())));
+  return buf;
+}
+
+#if defined(__linux__)
+// Appends the hex GNU build-id of a loaded object to id; false if it has none.
+static bool append_build_id(const struct dl_phdr_info* info, std::string& id) {
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+    if (ph.p_type != PT_NOTE) continue;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(info->dlpi_addr + ph.p_vaddr);
+    const uint8_t* end = p + ph.p_memsz;
+    while (p + sizeof(ElfW(Nhdr)) <= end) {
+      const ElfW(Nhdr)* nh = reinterpret_cast<const ElfW(Nhdr)*>(p);
+      const uint8_t* name = p + sizeof(*nh);
+      const uint8_t* desc = name + ((nh->n_namesz + 3) & ~3u);
+      if (desc + nh->n_descsz > end) break;
+      if (nh->n_type == NT_GNU_BUILD_ID && nh->n_namesz == 4 && std::memcmp(name, "GNU", 4) == 0) {
+        for (size_t k = 0; k < nh->n_descsz; ++k) {
+          char hex[3];
+          std::snprintf(hex, sizeof(hex), "%02x", desc[k]);
+          id += hex;
+        }
+        return true;
+      }
+      p = desc + ((nh->n_descsz + 3) & ~3u);
     }
-    uint8_t *data = read_file(f.c_str(), &len, max_len);
-    if (data == NULL) {
-      continue;
+  }
+  return false;
+}
+
+// Collects the build-id (else a file hash) of every loaded object, the
+// executable first. Objects without either, like the vDSO, add "".
+static int collect_object_ids(struct dl_phdr_info* info, size_t, void* out) {
+  std::vector<std::string>& ids = *static_cast<std::vector<std::string>*>(out);
+  std::string id;
+  if (!append_build_id(info, id)) {
+    const char* path = ids.empty() ? "/proc/self/exe" : info->dlpi_name;
+    if (path && *path) id = file_id(path);
+  }
+  ids.push_back(id);
+  return 0;
+}
+#endif
+
+// Identifies the running binary: the executable's build-id (else a hash of
+// its file), followed by a hash of the shared libraries' ids if it has any.
+static std::string binary_id(const char* argv0) {
+#if defined(__linux__)
+  (void)argv0;
+  std::vector<std::string> ids;
+  dl_iterate_phdr(collect_object_ids, &ids);
+  if (ids.empty() || ids[0].empty()) return "";
+  if (ids.size() == 1) return ids[0];
+  std::string libs;
+  for (size_t i = 1; i < ids.size(); ++i) libs += ids[i] + "\n";
+  char buf[24];
+  std::snprintf(buf, sizeof(buf), "-%016llx",
+                static_cast<unsigned long long>(
+                    input_hash(reinterpret_cast<const uint8_t*>(libs.data()), libs.size())));
+  return ids[0] + buf;
+#else
+  return file_id(argv0);
+#endif
+}
+
+// Hash of the run settings that can turn a pass into a failure.
+static std::string options_id(int64_t timeout_ns, uint64_t rss_limit_mb, size_t malloc_limit,
+                              size_t max_len) {
+  std::string opts = "timeout_ns=" + std::to_string(timeout_ns) +
+                     " rss_limit_mb=" + std::to_string(rss_limit_mb) +
+                     " malloc_limit=" + std::to_string(malloc_limit) +
+                     " max_len=" + std::to_string(max_len);
+  for (const char* var : {"ASAN_OPTIONS", "UBSAN_OPTIONS", "MSAN_OPTIONS", "LSAN_OPTIONS"}) {
+    const char* value = std::getenv(var);
+    opts += std::string(" ") + var + "=" + (value ? value : "");
+  }
+  char buf[24];
+  std::snprintf(buf, sizeof(buf), "%016llx",
+                static_cast<unsigned long long>(
+                    input_hash(reinterpret_cast<const uint8_t*>(opts.data()), opts.size())));
+  return buf;
+}
+
+class ReplayCache {
+ public:
+  ~ReplayCache() {
+    if (fd_ != -1) close(fd_);
+  }
+
+  // Loads DIR/<binary id>-<options>.pass, creating DIR if needed. With force
+  // nothing is skipped, but new passes are still recorded.
+  bool open(const std::string& dir, const char* argv0, const std::string& options, bool force) {
+    std::string id = binary_id(argv0);
+    if (id.empty()) {
+      fprintf(stderr, "==driver== replay cache: can't identify this binary\n");
+      return false;
+    }
+#if defined(_WIN32)
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0777);
+#endif
+    path_ = dir + "/" + id + "-" + options + ".pass";
+    force_ = force;
+    if (FILE* f = std::fopen(path_.c_str(), "r")) {
+      unsigned long long h;
+      while (std::fscanf(f, "%16llx\n", &h) == 1) passed_.insert(h);
+      std::fclose(f);
+    }
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (fd_ == -1) {
+      fprintf(stderr, "==driver== replay cache: can't write %s: %s\n", path_.c_str(), strerror(errno));
+      return false;
+    }
+    return true;
+  }
+
+  bool passed(uint64_t h) const { return !force_ && passed_.count(h) != 0; }
+
+  void record(uint64_t h) {
+    if (!passed_.insert(h).second) return;
+    char line[24];
+    int n = std::snprintf(line, sizeof(line), "%016llx\n", static_cast<unsigned long long>(h));
+    if (write(fd_, line, static_cast<size_t>(n)) != n) return;
+    ++recorded;
+  }
+
+  const std::string& path() const { return path_; }
+
+  uint64_t skipped = 0;
+  uint64_t recorded = 0;
+
+ private:
+  std::string path_;
+  std::unordered_set<uint64_t> passed_;
+  bool force_ = false;
+  int fd_ = -1;
+};
+
+static ReplayCache* g_replay_cache = nullptr;
+
+// -------------------- Timeouts (-timeout=MS, -report_slow_inputs=MS, -rss_limit_mb=MB) --------------------
+// Each run records the input and its start time; a periodic SIGALRM checks
+// them and exits with kTimeoutExitCode (libFuzzer's timeout code) once an
+// input overruns. Ticking on a fixed interval keeps the per-input cost down
+// to one clock read instead of re-arming a timer for every input. Interval
+// timers are not inherited across fork(), so forked workers call
+// start_watchdog() again. The same tick aborts once the peak RSS passes
+// -rss_limit_mb, so a blowup is reported as a crash of the input that
+// caused it before the OOM killer gets to the whole run.
+static const int kTimeoutExitCode = 70;
+static int64_t g_timeout_ns = 0;
+static int64_t g_slow_ns = 0;
+static uint64_t g_rss_limit_mb = 0;
+static std::atomic<const char*> g_current_input{nullptr};
+static std::atomic<int64_t> g_input_start_ns{0};
+
+static int64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void watch_begin(const char* path) {
+  g_current_input.store(path, std::memory_order_relaxed);
+  g_input_start_ns.store(now_ns(), std::memory_order_release);
+}
+
+// Ends the watched run and returns its duration in nanoseconds.
+static int64_t watch_end() {
+  int64_t elapsed = now_ns() - g_input_start_ns.load(std::memory_order_relaxed);
+  g_input_start_ns.store(0, std::memory_order_release);
+  return elapsed;
+}
+
+// Peak resident set size of this process so far, in MiB.
+static uint64_t peak_rss_mb() {
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#  if defined(__APPLE__)
+  return static_cast<uint64_t>(ru.ru_maxrss) >> 20;  // bytes
+#  else
+  return static_cast<uint64_t>(ru.ru_maxrss) >> 10;  // KiB
+#  endif
+#endif
+}
+
+#if !defined(_WIN32)
+// Async-signal-safe output for the SIGALRM handler and the allocation hooks.
+static void write_str(const char* s) {
+  ssize_t rc = write(STDERR_FILENO, s, std::strlen(s));
+  (void)rc;
+}
+
+static void write_u64(uint64_t v) {
+  char buf[21];
+  char* p = buf + sizeof(buf);
+  *--p = '\0';
+  do {
+    *--p = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v);
+  write_str(p);
+}
+
+#endif
+
+// Aborts (so every engine records a crash) if rss is above -rss_limit_mb.
+// Also called from the SIGALRM handler, hence the raw writes.
+static void check_rss_limit(const char* path, uint64_t rss) {
+  if (rss <= g_rss_limit_mb) return;
+#if !defined(_WIN32)
+  write_str("==driver== out-of-memory: ");
+  write_str(path ? path : "(stdin)");
+  write_str(" raised peak RSS to ");
+  write_u64(rss);
+  write_str(" MB (-rss_limit_mb=");
+  write_u64(g_rss_limit_mb);
+  write_str(")\n");
+#else
+  fprintf(stderr, "==driver== out-of-memory: %s raised peak RSS to %llu MB (-rss_limit_mb=%llu)\n",
+          path ? path : "(stdin)", static_cast<unsigned long long>(rss),
+          static_cast<unsigned long long>(g_rss_limit_mb));
+#endif
+  std::abort();
+}
+
+#if !defined(_WIN32)
+static void on_watchdog_tick(int) {
+  if (g_rss_limit_mb) {
+    check_rss_limit(g_current_input.load(std::memory_order_relaxed), peak_rss_mb());
+  }
+  if (g_timeout_ns <= 0) return;
+  int64_t start = g_input_start_ns.load(std::memory_order_acquire);
+  if (start == 0) return;
+  int64_t elapsed = now_ns() - start;
+  if (elapsed < g_timeout_ns) return;
+  const char* path = g_current_input.load(std::memory_order_relaxed);
+  write_str("==driver== timeout: ");
+  write_str(path ? path : "(stdin)");
+  write_str(" ran for ");
+  write_u64(static_cast<uint64_t>(elapsed / 1000000));
+  write_str(" ms (-timeout=");
+  write_u64(static_cast<uint64_t>(g_timeout_ns / 1000000));
+  write_str(")\n");
+  _exit(kTimeoutExitCode);
+}
+#endif
+
+static void start_watchdog() {
+#if !defined(_WIN32)
+  if (g_timeout_ns <= 0 && g_rss_limit_mb == 0) return;
+  struct sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_watchdog_tick;
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGALRM, &sa, nullptr);
+  // Check four times per timeout period, but at most every 10 ms (every
+  // 100 ms for the RSS limit alone).
+  int64_t tick_us = g_timeout_ns > 0 ? std::max<int64_t>(10000, g_timeout_ns / 4000) : 100000;
+  struct itimerval tv;
+  tv.it_interval.tv_sec = tick_us / 1000000;
+  tv.it_interval.tv_usec = tick_us % 1000000;
+  tv.it_value = tv.it_interval;
+  setitimer(ITIMER_REAL, &tv, nullptr);
+#endif
+}
+
+// -------------------- Memory (-malloc_stats=1, -malloc_limit_mb=MB) --------------------
+// libFuzzer's allocation checks for the other engines. -malloc_limit_mb
+// (default: -rss_limit_mb) aborts on any single allocation above the limit;
+// -malloc_stats=1 prints the allocations, bytes and frees of every exec with
+// the peak RSS after it, and a summary at the end. Sanitizer builds count
+// through the allocator's malloc/free hooks. Other glibc builds can opt in
+// with -DFUZZ_INTERPOSE_MALLOC=1, which interposes malloc, calloc, realloc
+// and free and forwards to glibc's own; that bypasses allocators loaded with
+// LD_PRELOAD/AFL_PRELOAD (libdislocator), so it is off by default. Only the
+// thread running the harness is counted, so the input walker's allocations
+// don't show up.
+#ifndef FUZZ_INTERPOSE_MALLOC
+#  define FUZZ_INTERPOSE_MALLOC 0
+#endif
+#if FUZZ_INTERPOSE_MALLOC && (!defined(__GLIBC__) || FUZZ_HAS_ALLOCATOR_SANITIZER)
+#  undef FUZZ_INTERPOSE_MALLOC
+#  define FUZZ_INTERPOSE_MALLOC 0
+#endif
+
+struct MemTotals {
+  uint64_t execs = 0;
+  uint64_t allocs = 0;
+  uint64_t bytes = 0;
+  uint64_t frees = 0;
+  uint64_t peak_rss_mb = 0;
+  uint64_t max_bytes = 0;
+  std::string max_bytes_input;
+};
+
+static bool g_malloc_stats = false;
+static size_t g_malloc_limit = 0;  // bytes; 0 = none
+static MemTotals g_mem_totals;
+static thread_local bool t_count_allocs = false;
+static thread_local uint64_t t_allocs = 0, t_alloc_bytes = 0, t_frees = 0;
+
+static void on_malloc_limit(size_t n) {
+  static std::atomic<bool> reported{false};
+  if (reported.exchange(true)) return;
+  const char* path = g_current_input.load(std::memory_order_relaxed);
+#if !defined(_WIN32)
+  write_str("==driver== out-of-memory: malloc(");
+  write_u64(n);
+  write_str(") exceeds -malloc_limit_mb=");
+  write_u64(g_malloc_limit >> 20);
+  write_str(" in ");
+  write_str(path ? path : "(stdin)");
+  write_str("\n");
+#else
+  fprintf(stderr, "==driver== out-of-memory: malloc(%llu) exceeds -malloc_limit_mb=%llu in %s\n",
+          static_cast<unsigned long long>(n), static_cast<unsigned long long>(g_malloc_limit >> 20),
+          path ? path : "(stdin)");
+#endif
+#if FUZZ_HAS_SANITIZER
+  if (__sanitizer_print_stack_trace) __sanitizer_print_stack_trace();
+#endif
+  std::abort();
+}
+
+static inline void note_alloc(size_t n) {
+  if (g_malloc_limit && n > g_malloc_limit) on_malloc_limit(n);
+  if (!t_count_allocs) return;
+  ++t_allocs;
+  t_alloc_bytes += n;
+}
+
+static inline void note_free() {
+  if (t_count_allocs) ++t_frees;
+}
+
+#if FUZZ_INTERPOSE_MALLOC
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void __libc_free(void*);
+
+void* malloc(size_t n) noexcept {
+  note_alloc(n);
+  return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t m) noexcept {
+  size_t total;
+  note_alloc(__builtin_mul_overflow(n, m, &total) ? SIZE_MAX : total);
+  return __libc_calloc(n, m);
+}
+
+void* realloc(void* p, size_t n) noexcept {
+  if (p) note_free();
+  if (n || !p) note_alloc(n);
+  return __libc_realloc(p, n);
+}
+
+void free(void* p) noexcept {
+  if (p) note_free();
+  __libc_free(p);
+}
+}
+#endif
+
+#if FUZZ_HAS_SANITIZER
+static void on_sanitizer_malloc(const volatile void*, size_t n) { note_alloc(n); }
+static void on_sanitizer_free(const volatile void* p) {
+  if (p) note_free();
+}
+#endif
+
+// Turns the allocation checks on; returns false if this build can't count.
+static bool start_malloc_tracking() {
+  bool hooked = false;
+#if FUZZ_HAS_SANITIZER
+  if (__sanitizer_install_malloc_and_free_hooks) {
+    hooked = __sanitizer_install_malloc_and_free_hooks(&on_sanitizer_malloc, &on_sanitizer_free) != 0;
+  }
+#endif
+  return hooked || FUZZ_INTERPOSE_MALLOC;
+}
+
+static void mem_begin() {
+  t_allocs = t_alloc_bytes = t_frees = 0;
+  t_count_allocs = g_malloc_stats;
+}
+
+// Ends a run of path: prints its -malloc_stats line and checks -rss_limit_mb.
+static void mem_end(const char* path) {
+  t_count_allocs = false;
+  uint64_t rss = peak_rss_mb();
+  MemTotals& t = g_mem_totals;
+  if (g_malloc_stats) {
+    fprintf(stderr, "==driver== mem: %s: %llu allocs, %llu bytes, %llu frees, peak RSS %llu MB",
+            path ? path : "(stdin)", static_cast<unsigned long long>(t_allocs),
+            static_cast<unsigned long long>(t_alloc_bytes), static_cast<unsigned long long>(t_frees),
+            static_cast<unsigned long long>(rss));
+    if (t.execs > 0 && rss > t.peak_rss_mb) {
+      fprintf(stderr, " (+%llu MB)", static_cast<unsigned long long>(rss - t.peak_rss_mb));
     }
+    fprintf(stderr, "\n");
+    ++t.execs;
+    t.allocs += t_allocs;
+    t.bytes += t_alloc_bytes;
+    t.frees += t_frees;
+    if (t_alloc_bytes > t.max_bytes || t.max_bytes_input.empty()) {
+      t.max_bytes = t_alloc_bytes;
+      t.max_bytes_input = path ? path : "(stdin)";
+    }
+  }
+  t.peak_rss_mb = std::max(t.peak_rss_mb, rss);
+  if (g_rss_limit_mb) check_rss_limit(path, rss);
+}
+
+static void report_memory() {
+  const MemTotals& t = g_mem_totals;
+  if (!g_malloc_stats || t.execs == 0) return;
+  double n = static_cast<double>(t.execs);
+  fprintf(stderr,
+          "==driver== mem: %llu execs, %.1f allocs, %.0f bytes and %.1f frees per exec, "
+          "peak RSS %llu MB; most bytes: %s (%llu)\n",
+          static_cast<unsigned long long>(t.execs), t.allocs / n, t.bytes / n, t.frees / n,
+          static_cast<unsigned long long>(t.peak_rss_mb), t.max_bytes_input.c_str(),
+          static_cast<unsigned long long>(t.max_bytes));
+}
+
+#if FUZZ_AFL_PERSISTENT
+// Run testcases from afl-fuzz in-process, __AFL_LOOP(iters) at a time before
+// the forkserver restarts us. The testcase lives in shared memory (or, when
+// not run by afl-fuzz, is read from stdin once by the AFL runtime).
+static void run_afl_persistent(unsigned iters, size_t max_len) {
+  // Deferred forkserver: everything up to here (including
+  // LLVMFuzzerInitialize) is executed once, not once per fork.
+  __AFL_INIT();
+  start_watchdog();  // for -rss_limit_mb; timers don't survive the fork
+  const uint8_t* buf = __AFL_FUZZ_TESTCASE_BUF;
+#if FUZZ_HAS_SANITIZER
+  // The shared memory region is larger than any testcase, so overreads would
+  // go unnoticed. Copy each input to the tail of one heap buffer instead so
+  // reading past the end still lands in the ASan redzone.
+  uint8_t* tail = static_cast<uint8_t*>(std::malloc(max_len ? max_len : 1));
+  if (tail == NULL) {
+    std::perror("malloc");
+    std::exit(1);
+  }
+#endif
+  while (__AFL_LOOP(iters)) {
+    size_t len = __AFL_FUZZ_TESTCASE_LEN;
+    if (len > max_len) len = max_len;
+#if FUZZ_HAS_SANITIZER
+    uint8_t* data = tail + max_len - len;
+    std::memcpy(data, buf, len);
     LLVMFuzzerTestOneInput(data, len);
-    free(data);
-    ++executed;
+#else
+    LLVMFuzzerTestOneInput(buf, len);
+#endif
+    if (g_rss_limit_mb) check_rss_limit(nullptr, peak_rss_mb());
+  }
+#if FUZZ_HAS_SANITIZER
+  std::free(tail);
+#endif
+}
+#endif
+
+// Runs the harness on data. path names the input in timeout, slow-input and
+// memory reports.
+static void run_one(const char* path, const uint8_t* data, size_t size) {
+  const bool mem = g_malloc_stats || g_malloc_limit || g_rss_limit_mb;
+  if (g_timeout_ns <= 0 && g_slow_ns <= 0 && !mem) {
+    LLVMFuzzerTestOneInput(data, size);
+    return;
+  }
+  watch_begin(path);
+  if (mem) mem_begin();
+  LLVMFuzzerTestOneInput(data, size);
+  int64_t elapsed = watch_end();
+  if (mem) mem_end(path);
+  if (g_slow_ns > 0 && elapsed >= g_slow_ns) {
+    fprintf(stderr, "==driver== slow input: %s took %.1f ms\n", path ? path : "(stdin)",
+            static_cast<double>(elapsed) / 1e6);
+  }
+}
+
+// Runs the harness once on in, unless the replay cache knows it passes.
+// Returns false if it can't be read.
+static bool run_input(InputLoader& loader, const Input& in, size_t max_len) {
+  if (!loader.load(in, max_len)) return false;
+  uint64_t h = 0;
+  if (g_replay_cache) {
+    h = input_hash(loader.data(), loader.size());
+    if (g_replay_cache->passed(h)) {
+      ++g_replay_cache->skipped;
+      loader.release();
+      return true;
+    }
+  }
+  run_one(in.path.c_str(), loader.data(), loader.size());
+  if (g_replay_cache) g_replay_cache->record(h);
+  loader.release();
+  return true;
+}
+
+// -------------------- Source-based coverage (fuzz-coverage builds) --------------------
+// clang's profile runtime expands %p in LLVM_PROFILE_FILE once, at startup,
+// so forked workers would all append to the parent's file. Each worker
+// switches to a file named after its own pid, drops the counters it inherited
+// from the parent (which writes those itself) and writes its profile at most
+// once a second, resetting the counters after each write. The runtime appends
+// every write and llvm-profdata sums them, so the counts stay exact. Crashes
+// write the profile from the signal handler before the process dies, so only
+// a timeout loses anything: the worker's last second. Patterns with %m
+// (merged by the runtime) keep their name; %c (continuous mode) is left alone.
+#if !defined(_WIN32)
+extern "C" void __llvm_profile_set_filename(const char*) __attribute__((weak));
+extern "C" int __llvm_profile_write_file(void) __attribute__((weak));
+extern "C" void __llvm_profile_reset_counters(void) __attribute__((weak));
+
+static const int64_t kProfileWriteIntervalNs = 1000000000;
+static bool g_profile_worker = false;
+static int64_t g_profile_written_ns = 0;
+
+static void profile_worker_begin() {
+  if (!__llvm_profile_set_filename || !__llvm_profile_write_file || !__llvm_profile_reset_counters) return;
+  const char* env = std::getenv("LLVM_PROFILE_FILE");
+  std::string pattern = env && *env ? env : "default.profraw";
+  if (pattern.find("%c") != std::string::npos) return;
+  if (pattern.find("%m") == std::string::npos) {
+    std::string pid = std::to_string(getpid());
+    std::string name;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      if (pattern.compare(i, 2, "%p") == 0) {
+        name += pid;
+        ++i;
+      } else {
+        name += pattern[i];
+      }
+    }
+    if (name == pattern) name += "." + pid;
+    __llvm_profile_set_filename(name.c_str());
+  }
+  __llvm_profile_reset_counters();
+  g_profile_worker = true;
+  g_profile_written_ns = now_ns();
+}
+
+// Called between inputs; the final write happens at exit.
+static void profile_worker_tick() {
+  if (!g_profile_worker) return;
+  int64_t now = now_ns();
+  if (now - g_profile_written_ns < kProfileWriteIntervalNs) return;
+  if (__llvm_profile_write_file() == 0) __llvm_profile_reset_counters();
+  g_profile_written_ns = now;
+}
+
+static void on_fatal_signal(int sig) {
+  // The crash may hold a libc lock the write needs; SIGALRM ends a stuck one
+  signal(SIGALRM, SIG_DFL);
+  alarm(2);
+  __llvm_profile_write_file();
+  raise(sig);
+}
+
+// Keeps the coverage of inputs that crash (and of those before them).
+// Forked workers inherit the handlers.
+static void profile_catch_crashes() {
+  if (!__llvm_profile_write_file) return;
+  struct sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_fatal_signal;
+  sa.sa_flags = SA_RESETHAND | SA_NODEFER;
+  for (int sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) sigaction(sig, &sa, nullptr);
+}
+#endif
+
+// -------------------- Forked replay (-jobs=N, -keep_going=1) --------------------
+// Inputs run in forked workers so a crash only takes down one child. Workers
+// are forked after LLVMFuzzerInitialize and claim contiguous batches of input
+// indices from a counter in shared memory, so one slow input only holds up
+// one worker. Each worker publishes the batch and input it is running; when a
+// worker dies the parent records that input, reschedules the rest of its
+// batch and forks a replacement.
+//
+// -jobs=N runs N long-lived workers that claim one input at a time.
+// -keep_going=1 forks one child per -batch=N inputs instead, and afterwards
+// re-runs each crashing input alone; if it doesn't crash by itself, the
+// inputs before it in the batch are bisected to find the one it depends on.
+#if !defined(_WIN32)
+static const size_t kNoInput = SIZE_MAX;
+
+struct WorkQueue {
+  std::atomic<size_t> next;
+  std::atomic<size_t> executed;
+  std::atomic<uint64_t> cache_skipped;   // the workers' replay cache counters
+  std::atomic<uint64_t> cache_recorded;
+};
+
+struct WorkerSlot {
+  std::atomic<size_t> current;
+  std::atomic<size_t> batch_begin;
+  std::atomic<size_t> batch_end;
+};
+
+struct ForkOptions {
+  int jobs = 1;
+  size_t batch = 0;  // inputs per child; 0 keeps workers alive until the queue is empty
+  bool verify = false;
+  int64_t* times = nullptr;  // shared memory: ns of each input's harness call, if set
+};
+
+struct Crash {
+  size_t input;   // index into files, or kNoInput if it died between inputs
+  size_t begin;   // first input this child ran in the crashing batch
+  int status;
+  std::string report;  // sanitizer report file, if one was written
+  std::string verdict;
+};
+
+// Formats a wait() status as "signal 11 (Segmentation fault)" / "exit code 1".
+static std::string describe_status(int status) {
+  char buf[128];
+  if (WIFEXITED(status) && WEXITSTATUS(status) == kTimeoutExitCode) {
+    std::snprintf(buf, sizeof(buf), "timeout (exit code %d)", kTimeoutExitCode);
+  } else if (WIFSIGNALED(status)) {
+    std::snprintf(buf, sizeof(buf), "signal %d (%s)", WTERMSIG(status), strsignal(WTERMSIG(status)));
+  } else {
+    std::snprintf(buf, sizeof(buf), "exit code %d", WEXITSTATUS(status));
+  }
+  return buf;
+}
+
+// Shell-style exit code for a wait() status.
+static int exit_code_for(int status) {
+  return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+}
+
+static bool exited_cleanly(int status) {
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Sanitizers append ".<pid>" to the report path set from
+// AFL_DRIVER_STDERR_DUPLICATE_FILENAME.
+static std::string report_path_for(pid_t pid) {
+  const char* dup = std::getenv("AFL_DRIVER_STDERR_DUPLICATE_FILENAME");
+  if (!dup) return "";
+  std::string path = std::string(dup) + "." + std::to_string(pid);
+  return is_file(path.c_str()) ? path : "";
+}
+
+[[noreturn]] static void worker_main(WorkQueue* q, WorkerSlot* slot,
+                                     const std::vector<Input>& files, size_t limit,
+                                     size_t max_len, const ForkOptions& opts, size_t begin,
+                                     size_t end) {
+  start_watchdog();
+  profile_worker_begin();
+  InputLoader loader;
+  size_t chunk = opts.batch ? opts.batch : 1;
+  size_t done = 0;
+  for (;;) {
+    if (begin >= end) {
+      begin = q->next.fetch_add(chunk);
+      if (begin >= limit) break;
+      end = std::min(begin + chunk, limit);
+    }
+    slot->batch_begin.store(begin);
+    slot->batch_end.store(end);
+    for (; begin < end; ++begin) {
+      slot->current.store(begin);
+      if (!opts.times) {
+        run_input(loader, files[begin], max_len);
+        if (g_replay_cache) {
+          q->cache_skipped.fetch_add(g_replay_cache->skipped);
+          q->cache_recorded.fetch_add(g_replay_cache->recorded);
+          g_replay_cache->skipped = g_replay_cache->recorded = 0;
+        }
+      } else if (loader.load(files[begin], max_len)) {
+        const int64_t t0 = now_ns();
+        run_one(files[begin].path.c_str(), loader.data(), loader.size());
+        opts.times[begin] = now_ns() - t0;
+        loader.release();
+      }
+      q->executed.fetch_add(1);
+      profile_worker_tick();
+    }
+    slot->current.store(kNoInput);
+    done += chunk;
+    if (opts.batch && done >= opts.batch) break;
+  }
+  std::fflush(nullptr);
+  std::exit(0);
+}
+
+// Runs files[first..] in one throwaway child and returns its wait() status.
+static int run_in_child(const std::vector<Input>& files, const std::vector<size_t>& first,
+                        size_t last, size_t max_len) {
+  std::fflush(nullptr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    g_replay_cache = nullptr;  // every input of the prefix has to run
+    start_watchdog();
+    InputLoader loader;
+    for (size_t i : first) run_input(loader, files[i], max_len);
+    run_input(loader, files[last], max_len);
+    std::fflush(nullptr);
+    std::exit(0);
+  }
+  int status = 0;
+  if (pid == -1 || waitpid(pid, &status, 0) == -1) return 0;
+  return status;
+}
+
+// Decides whether a crash reproduces on its own, or which earlier input of
+// its batch has to run first.
+static std::string verify_crash(const std::vector<Input>& files, const Crash& c,
+                                size_t max_len) {
+  if (c.input == kNoInput) return "";
+  if (!exited_cleanly(run_in_child(files, {}, c.input, max_len))) return "reproduces alone";
+
+  // Find the latest k in [begin, input) such that running files[k..input)
+  // before the crashing input still crashes; files[k] is then the input the
+  // crash depends on.
+  auto crashes_after = [&](size_t k) {
+    std::vector<size_t> prefix;
+    for (size_t i = k; i < c.input; ++i) prefix.push_back(i);
+    return !exited_cleanly(run_in_child(files, prefix, c.input, max_len));
+  };
+  if (c.begin >= c.input || !crashes_after(c.begin)) return "did not reproduce";
+  size_t lo = c.begin, hi = c.input;  // crashes_after(lo) holds, hi is exclusive
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (crashes_after(mid)) lo = mid;
+    else hi = mid;
+  }
+  return "only after " + files[lo].path;
+}
+
+// Runs files[0..limit) in opts.jobs workers until every input has run once,
+// collecting the children that died. Returns the number of inputs executed,
+// or -1 if the shared memory can't be mapped.
+static long long fork_workers(const std::vector<Input>& files, size_t limit, size_t max_len,
+                              const ForkOptions& opts, std::vector<Crash>& crashes) {
+  size_t shm_len = sizeof(WorkQueue) + sizeof(WorkerSlot) * static_cast<size_t>(opts.jobs);
+  void* shm = mmap(nullptr, shm_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shm == MAP_FAILED) {
+    std::perror("mmap");
+    return -1;
+  }
+  WorkQueue* q = new (shm) WorkQueue();
+  WorkerSlot* slots = reinterpret_cast<WorkerSlot*>(q + 1);
+  for (int w = 0; w < opts.jobs; ++w) new (&slots[w]) WorkerSlot();
+
+  // Leftovers of batches whose child crashed part-way through.
+  std::vector<std::pair<size_t, size_t>> pending;
+  std::vector<pid_t> pids(static_cast<size_t>(opts.jobs), -1);
+  auto spawn = [&](int w) {
+    size_t begin = 0, end = 0;
+    if (!pending.empty()) {
+      begin = pending.back().first;
+      end = pending.back().second;
+      pending.pop_back();
+    } else if (q->next.load() >= limit) {
+      return false;
+    }
+    slots[w].current.store(kNoInput);
+    std::fflush(nullptr);
+    pid_t pid = fork();
+    if (pid == 0) worker_main(q, &slots[w], files, limit, max_len, opts, begin, end);
+    if (pid == -1) {
+      std::perror("fork");
+      if (begin < end) pending.emplace_back(begin, end);
+    }
+    pids[static_cast<size_t>(w)] = pid;
+    return pid != -1;
+  };
+
+  int live = 0;
+  for (int w = 0; w < opts.jobs; ++w) live += spawn(w);
+
+  while (live > 0) {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid == -1) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    auto it = std::find(pids.begin(), pids.end(), pid);
+    if (it == pids.end()) continue;
+    int w = static_cast<int>(it - pids.begin());
+    *it = -1;
+    --live;
+
+    if (!exited_cleanly(status)) {
+      size_t i = slots[w].current.load();
+      Crash c{i, slots[w].batch_begin.load(), status, report_path_for(pid), ""};
+      if (i != kNoInput) {
+        q->executed.fetch_add(1);
+        size_t end = slots[w].batch_end.load();
+        if (i + 1 < end) pending.emplace_back(i + 1, end);
+      }
+      fprintf(stderr, "==driver== worker %d (pid %d) died on %s: %s\n", w, static_cast<int>(pid),
+              i == kNoInput ? "(between inputs)" : files[i].path.c_str(), describe_status(status).c_str());
+      crashes.push_back(c);
+    }
+    live += spawn(w);
+  }
+  const long long executed = static_cast<long long>(q->executed.load());
+  if (g_replay_cache) {
+    g_replay_cache->skipped += q->cache_skipped.load();
+    g_replay_cache->recorded += q->cache_recorded.load();
+  }
+  munmap(shm, shm_len);
+  return executed;
+}
+
+static int run_files_forked(const std::vector<Input>& files, size_t limit, size_t max_len,
+                            const ForkOptions& opts) {
+  std::vector<Crash> crashes;
+  const long long executed = fork_workers(files, limit, max_len, opts, crashes);
+  if (executed < 0) return 1;
+
+  if (opts.verify) {
+    for (auto& c : crashes) c.verdict = verify_crash(files, c, max_len);
+  }
+
+  // Inputs the replay cache skipped are counted in its own summary.
+  const long long skipped = g_replay_cache ? static_cast<long long>(g_replay_cache->skipped) : 0;
+  fprintf(stderr, "==driver== %lld inputs replayed by %d worker(s), %zu crashed\n", executed - skipped,
+          opts.jobs, crashes.size());
+  for (const auto& c : crashes) {
+    fprintf(stderr, "==driver==   %s: %s", c.input == kNoInput ? "(between inputs)" : files[c.input].path.c_str(),
+            describe_status(c.status).c_str());
+    if (!c.report.empty()) fprintf(stderr, ", report %s", c.report.c_str());
+    if (!c.verdict.empty()) fprintf(stderr, " [%s]", c.verdict.c_str());
+    fprintf(stderr, "\n");
+  }
+  return crashes.empty() ? 0 : exit_code_for(crashes.front().status);
+}
+#endif
+
+// -------------------- Benchmark (-bench=1) --------------------
+// Loops over the corpus timing each LLVMFuzzerTestOneInput call with a
+// monotonic clock, until -bench_seconds or -bench_iters is reached. Inputs are
+// loaded once up front (each in its own exact-size allocation) so the numbers
+// measure the harness, not the filesystem. Latencies go into a log-linear
+// histogram (16 sub-buckets per power of two, ~6% resolution) so long runs
+// need constant memory.
+struct BenchOptions {
+  double seconds = 0;  // 0 = no time limit
+  uint64_t iters = 0;  // 0 = no iteration limit
+  size_t top = 10;
+  std::string json_path;
+};
+
+class LatencyHistogram {
+ public:
+  void add(uint64_t ns) {
+    ++counts_[bucket_for(ns)];
+    ++total_;
+    max_ = std::max(max_, ns);
+  }
+
+  // Upper bound of the bucket holding the q-th quantile.
+  uint64_t quantile(double q) const {
+    if (total_ == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total_ - 1)) + 1, seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+      seen += counts_[b];
+      if (seen >= rank) return std::min(upper_bound(b), max_);
+    }
+    return max_;
+  }
+
+  uint64_t max() const { return max_; }
+
+ private:
+  static const size_t kSubBits = 4;
+  static const size_t kBuckets = (64 - kSubBits + 1) << kSubBits;
+
+  static size_t bucket_for(uint64_t v) {
+    if (v < (1u << kSubBits)) return static_cast<size_t>(v);
+    size_t msb = 63 - static_cast<size_t>(__builtin_clzll(v));
+    size_t shift = msb - kSubBits;
+    return ((shift + 1) << kSubBits) + static_cast<size_t>((v >> shift) & ((1u << kSubBits) - 1));
+  }
+
+  static uint64_t upper_bound(size_t b) {
+    if (b < (1u << kSubBits)) return b;
+    size_t shift = (b >> kSubBits) - 1;
+    uint64_t base = (uint64_t(1) << kSubBits) | (b & ((1u << kSubBits) - 1));
+    return ((base + 1) << shift) - 1;
+  }
+
+  uint64_t counts_[kBuckets] = {};
+  uint64_t total_ = 0;
+  uint64_t max_ = 0;
+};
+
+static std::string json_escape(const std::string& in) {
+  std::string out;
+  for (char ch : in) {
+    unsigned char c = static_cast<unsigned char>(ch);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += ch;
+    } else if (c < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += ch;
+    }
+  }
+  return out;
+}
+
+// Formats nanoseconds with a unit that keeps three significant digits.
+static std::string format_ns(double ns) {
+  char buf[32];
+  if (ns < 1e3) std::snprintf(buf, sizeof(buf), "%.0f ns", ns);
+  else if (ns < 1e6) std::snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+  else if (ns < 1e9) std::snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+  else std::snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+  return buf;
+}
+
+static int run_benchmark(const std::vector<Input>& files, size_t limit, size_t max_len,
+                         const BenchOptions& opts) {
+  using clock = std::chrono::steady_clock;
+
+  struct BenchInput {
+    std::string path;
+    std::vector<uint8_t> data;
+    uint64_t runs = 0, total_ns = 0, max_ns = 0;
+  };
+  std::vector<BenchInput> inputs;
+  InputLoader loader;
+  for (size_t i = 0; i < limit; ++i) {
+    if (!loader.load(files[i], max_len)) continue;
+    inputs.push_back({files[i].path, std::vector<uint8_t>(loader.data(), loader.data() + loader.size())});
+    loader.release();
+  }
+  if (inputs.empty()) {
+    fprintf(stderr, "==bench== no readable inputs\n");
+    return 1;
+  }
+
+  LatencyHistogram hist;
+  uint64_t execs = 0;
+  const auto start = clock::now();
+  const auto deadline = start + std::chrono::duration_cast<clock::duration>(
+                                    std::chrono::duration<double>(opts.seconds));
+  auto now = start;
+  bool done = false;
+  while (!done) {
+    for (auto& in : inputs) {
+      if (g_timeout_ns > 0) watch_begin(in.path.c_str());
+      const auto t0 = clock::now();
+      LLVMFuzzerTestOneInput(in.data.data(), in.data.size());
+      now = clock::now();
+      if (g_timeout_ns > 0) watch_end();
+      uint64_t ns = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now - t0).count());
+      hist.add(ns);
+      ++in.runs;
+      in.total_ns += ns;
+      in.max_ns = std::max(in.max_ns, ns);
+      ++execs;
+      if ((opts.iters && execs >= opts.iters) || (opts.seconds > 0 && now >= deadline)) {
+        done = true;
+        break;
+      }
+    }
+  }
+  double secs = std::chrono::duration<double>(now - start).count();
+  double rate = secs > 0 ? static_cast<double>(execs) / secs : 0;
+
+  std::vector<const BenchInput*> slowest;
+  for (const auto& in : inputs) {
+    if (in.runs) slowest.push_back(&in);
+  }
+  auto mean = [](const BenchInput* in) { return static_cast<double>(in->total_ns) / static_cast<double>(in->runs); };
+  std::sort(slowest.begin(), slowest.end(),
+            [&](const BenchInput* a, const BenchInput* b) { return mean(a) > mean(b); });
+  if (slowest.size() > opts.top) slowest.resize(opts.top);
+
+  fprintf(stderr, "==bench== %llu execs over %zu inputs in %.2f s: %.0f exec/s\n",
+          static_cast<unsigned long long>(execs), inputs.size(), secs, rate);
+  fprintf(stderr, "==bench== latency p50 %s, p90 %s, p99 %s, max %s\n",
+          format_ns(static_cast<double>(hist.quantile(0.50))).c_str(),
+          format_ns(static_cast<double>(hist.quantile(0.90))).c_str(),
+          format_ns(static_cast<double>(hist.quantile(0.99))).c_str(),
+          format_ns(static_cast<double>(hist.max())).c_str());
+  fprintf(stderr, "==bench== slowest inputs (mean, max):\n");
+  for (const auto* in : slowest) {
+    fprintf(stderr, "==bench==   %10s %10s  %s\n", format_ns(mean(in)).c_str(),
+            format_ns(static_cast<double>(in->max_ns)).c_str(), in->path.c_str());
+  }
+
+  if (!opts.json_path.empty()) {
+    FILE* out = opts.json_path == "-" ? stdout : std::fopen(opts.json_path.c_str(), "w");
+    if (!out) {
+      fprintf(stderr, "can't write %s: %s\n", opts.json_path.c_str(), strerror(errno));
+      return 1;
+    }
+    fprintf(out, "{\"execs\": %llu, \"inputs\": %zu, \"seconds\": %.6f, \"execs_per_sec\": %.1f,\n",
+            static_cast<unsigned long long>(execs), inputs.size(), secs, rate);
+    fprintf(out, " \"latency_ns\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu},\n",
+            static_cast<unsigned long long>(hist.quantile(0.50)),
+            static_cast<unsigned long long>(hist.quantile(0.90)),
+            static_cast<unsigned long long>(hist.quantile(0.99)),
+            static_cast<unsigned long long>(hist.max()));
+    fprintf(out, " \"slowest\": [");
+    for (size_t i = 0; i < slowest.size(); ++i) {
+      fprintf(out, "%s\n  {\"file\": \"%s\", \"mean_ns\": %.0f, \"max_ns\": %llu, \"runs\": %llu}",
+              i ? "," : "", json_escape(slowest[i]->path).c_str(), mean(slowest[i]),
+              static_cast<unsigned long long>(slowest[i]->max_ns),
+              static_cast<unsigned long long>(slowest[i]->runs));
+    }
+    fprintf(out, "]}\n");
+    if (out != stdout) std::fclose(out);
+  }
+  return 0;
+}
+
+// -------------------- Thread stress (-threads=N) --------------------
+// Calls LLVMFuzzerTestOneInput from several threads at once, to surface data
+// races (build with the fuzz-tsan preset) and to show how throughput scales.
+// The corpus is preloaded as for -bench, then the harness runs for
+// -stress_seconds at 1, 2, 4, ... threads up to N. By default every thread
+// walks the whole corpus from its own starting offset, so threads hit the
+// same inputs at different times; -thread_shards=1 gives each thread its own
+// slice instead.
+struct StressOptions {
+  int threads = 0;
+  bool shards = false;
+  double seconds = 2;
+};
+
+static int run_stress(const std::vector<Input>& files, size_t limit, size_t max_len,
+                      const StressOptions& opts) {
+  using clock = std::chrono::steady_clock;
+
+  std::vector<std::vector<uint8_t>> inputs;
+  InputLoader loader;
+  for (size_t i = 0; i < limit; ++i) {
+    if (!loader.load(files[i], max_len)) continue;
+    inputs.emplace_back(loader.data(), loader.data() + loader.size());
+    loader.release();
+  }
+  if (inputs.empty()) {
+    fprintf(stderr, "==stress== no readable inputs\n");
+    return 1;
+  }
+
+  std::vector<int> steps;
+  for (int n = 1; n < opts.threads; n *= 2) steps.push_back(n);
+  steps.push_back(opts.threads);
+
+  fprintf(stderr, "==stress== %zu inputs, %s, %.1f s per step\n", inputs.size(),
+          opts.shards ? "sharded per thread" : "shared by all threads", opts.seconds);
+  fprintf(stderr, "==stress== %7s %12s %8s %10s\n", "threads", "exec/s", "speedup", "efficiency");
+  double base = 0;
+  for (int n : steps) {
+    // One cache line per thread so the counters don't contend.
+    struct alignas(64) Counter {
+      uint64_t execs = 0;
+    };
+    std::vector<Counter> counts(static_cast<size_t>(n));
+    std::atomic<bool> go(false), stop(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n; ++t) {
+      threads.emplace_back([&, t] {
+        const size_t count = inputs.size(), nt = static_cast<size_t>(n), ti = static_cast<size_t>(t);
+        std::vector<size_t> mine;
+        if (opts.shards) {
+          for (size_t i = ti; i < count; i += nt) mine.push_back(i);
+          if (mine.empty()) mine.push_back(ti % count);  // more threads than inputs
+        } else {
+          for (size_t k = 0; k < count; ++k) mine.push_back((count * ti / nt + k) % count);
+        }
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+        uint64_t execs = 0;
+        for (size_t k = 0; !stop.load(std::memory_order_relaxed); k = (k + 1) % mine.size()) {
+          const auto& in = inputs[mine[k]];
+          LLVMFuzzerTestOneInput(in.data(), in.size());
+          ++execs;
+        }
+        counts[ti].execs = execs;
+      });
+    }
+    const auto start = clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds));
+    stop.store(true);
+    for (auto& th : threads) th.join();
+    double secs = std::chrono::duration<double>(clock::now() - start).count();
+
+    uint64_t execs = 0;
+    for (const auto& c : counts) execs += c.execs;
+    double rate = secs > 0 ? static_cast<double>(execs) / secs : 0;
+    if (n == 1) base = rate;
+    double speedup = base > 0 ? rate / base : 0;
+    fprintf(stderr, "==stress== %7d %12.0f %7.2fx %9.0f%%\n", n, rate, speedup, 100 * speedup / n);
+  }
+  return 0;
+}
+
+// -------------------- Edge coverage (-minimize_corpus=OUTDIR) --------------------
+// Builds with -fsanitize-coverage=trace-pc-guard (the fuzz-standalone-cov
+// preset defines FUZZ_TRACE_PC_GUARD) call back into the driver on every
+// edge. Each guard holds its edge's index; the first hit in an input zeroes
+// it and logs it, so later hits cost one load. cov_reset() re-arms the
+// logged guards before the next input, which leaves the log as the list of
+// edges that input covers.
+#if FUZZ_TRACE_PC_GUARD
+struct CovHit {
+  uint32_t* guard;
+  uint32_t index;
+};
+static uint32_t g_cov_guards = 0;
+static CovHit* g_cov_hits = nullptr;  // one slot per guard, since each is logged once
+static size_t g_cov_nhits = 0;
+
+extern "C" void __sanitizer_cov_trace_pc_guard_init(uint32_t* start, uint32_t* stop) {
+  if (start == stop || *start) return;  // already initialized
+  for (uint32_t* g = start; g < stop; ++g) *g = ++g_cov_guards;
+  g_cov_hits = static_cast<CovHit*>(std::realloc(g_cov_hits, sizeof(CovHit) * g_cov_guards));
+  if (!g_cov_hits) std::abort();
+}
+
+extern "C" void __sanitizer_cov_trace_pc_guard(uint32_t* guard) {
+  uint32_t index = *guard;
+  if (!index) return;
+  *guard = 0;
+  size_t n = g_cov_nhits;
+  if (n < g_cov_guards) {  // only exceeded by racing threads (-threads)
+    g_cov_hits[n] = {guard, index};
+    g_cov_nhits = n + 1;
+  }
+}
+#endif
+
+static size_t cov_edges() {
+#if FUZZ_TRACE_PC_GUARD
+  return g_cov_guards;
+#else
+  return 0;
+#endif
+}
+
+static void cov_reset() {
+#if FUZZ_TRACE_PC_GUARD
+  for (size_t i = 0; i < g_cov_nhits; ++i) *g_cov_hits[i].guard = g_cov_hits[i].index;
+  g_cov_nhits = 0;
+#endif
+}
+
+// Appends the edges hit since cov_reset() to out.
+static void cov_collect(std::vector<uint32_t>& out) {
+#if FUZZ_TRACE_PC_GUARD
+  for (size_t i = 0; i < g_cov_nhits; ++i) out.push_back(g_cov_hits[i].index);
+#else
+  (void)out;
+#endif
+}
+
+// Replays the corpus recording each input's edges, then copies a greedy set
+// cover to out_dir: repeatedly the input adding the most uncovered edges
+// (smaller inputs win ties) until nothing adds any. Gains only shrink as
+// edges get covered, so a stale heap entry is re-scored when popped instead
+// of rescoring every input each round. Files are named by content hash, like
+// libFuzzer's -merge output.
+static int minimize_corpus(const std::vector<Input>& files, size_t limit, size_t max_len,
+                           const std::string& out_dir) {
+  if (cov_edges() == 0) {
+    fprintf(stderr, "==driver== -minimize_corpus needs a build with -fsanitize-coverage=trace-pc-guard "
+                    "(the fuzz-standalone-cov preset)\n");
+    return 1;
+  }
+
+  struct Candidate {
+    size_t input;
+    size_t size;
+    std::vector<uint32_t> edges;
+  };
+  std::vector<Candidate> cands;
+  InputLoader loader;
+  start_watchdog();
+  for (size_t i = 0; i < limit; ++i) {
+    if (!loader.load(files[i], max_len)) continue;
+    Candidate c{i, loader.size(), {}};
+    cov_reset();
+    run_one(files[i].path.c_str(), loader.data(), loader.size());
+    cov_collect(c.edges);
+    loader.release();
+    if (!c.edges.empty()) cands.push_back(std::move(c));
+  }
+
+  std::vector<uint64_t> covered(cov_edges() / 64 + 1, 0);
+  auto gain = [&](const Candidate& c) {
+    size_t g = 0;
+    for (uint32_t e : c.edges) g += !(covered[e / 64] >> (e % 64) & 1);
+    return g;
+  };
+  // (gain, candidate); larger gain first, then smaller input, then corpus order
+  typedef std::pair<size_t, size_t> Entry;
+  auto worse = [&](const Entry& a, const Entry& b) {
+    if (a.first != b.first) return a.first < b.first;
+    const Candidate &ca = cands[a.second], &cb = cands[b.second];
+    if (ca.size != cb.size) return ca.size > cb.size;
+    return ca.input > cb.input;
+  };
+  std::priority_queue<Entry, std::vector<Entry>, decltype(worse)> heap(worse);
+  for (size_t i = 0; i < cands.size(); ++i) heap.push({cands[i].edges.size(), i});
+
+  std::vector<size_t> kept;
+  size_t reached = 0;
+  while (!heap.empty()) {
+    Entry top = heap.top();
+    heap.pop();
+    top.first = gain(cands[top.second]);
+    if (top.first == 0) continue;
+    if (!heap.empty() && worse(top, heap.top())) {
+      heap.push(top);
+      continue;
+    }
+    for (uint32_t e : cands[top.second].edges) covered[e / 64] |= uint64_t(1) << (e % 64);
+    reached += top.first;
+    kept.push_back(cands[top.second].input);
+  }
+  std::sort(kept.begin(), kept.end());
+
+#if defined(_WIN32)
+  _mkdir(out_dir.c_str());
+#else
+  mkdir(out_dir.c_str(), 0777);
+#endif
+  for (size_t i : kept) {
+    if (!loader.load(files[i], max_len)) return 1;
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx",
+                  static_cast<unsigned long long>(input_hash(loader.data(), loader.size())));
+    std::string path = out_dir + name;
+    FILE* out = std::fopen(path.c_str(), "wb");
+    bool ok = out && std::fwrite(loader.data(), 1, loader.size(), out) == loader.size();
+    if (out) ok = (std::fclose(out) == 0) && ok;
+    loader.release();
+    if (!ok) {
+      fprintf(stderr, "can't write %s: %s\n", path.c_str(), strerror(errno));
+      return 1;
+    }
+  }
+  fprintf(stderr, "==driver== minimize: kept %zu of %zu inputs, covering all %zu edges reached (%zu instrumented), in %s\n",
+          kept.size(), limit, reached, cov_edges(), out_dir.c_str());
+  return 0;
+}
+
+// -------------------- Corpus analytics (-corpus_stats=1, -dedup=1) --------------------
+// Summarizes the inputs: count and bytes, a power-of-two size histogram,
+// exact duplicates, and the size percentiles of the unique inputs with the
+// max length to give each engine. Every input is read in full and keyed by
+// its size and input_hash(), like the replay cache. Hashing runs on -jobs
+// threads (default: all cores), since the time goes into reading files
+// rather than hashing. -corpus_stats=1 also times one run of each unique
+// input in -jobs forked workers and lists the slowest, then the inputs that
+// crashed or timed out. -dedup=1 deletes every duplicate file once it
+// compares equal byte for byte to the copy that stays, the first one named
+// on the command line; duplicates inside packs are only counted.
+struct CorpusOptions {
+  bool stats = false;
+  bool dedup = false;
+  int threads = 0;  // 0 = all cores
+  size_t top = 10;
+};
+
+static std::string format_bytes(double n) {
+  char buf[32];
+  if (n < 1024) std::snprintf(buf, sizeof(buf), "%.0f B", n);
+  else if (n < 1024.0 * 1024) std::snprintf(buf, sizeof(buf), "%.1f KiB", n / 1024);
+  else if (n < 1024.0 * 1024 * 1024) std::snprintf(buf, sizeof(buf), "%.1f MiB", n / (1024.0 * 1024));
+  else std::snprintf(buf, sizeof(buf), "%.2f GiB", n / (1024.0 * 1024 * 1024));
+  return buf;
+}
+
+// Smallest power of two >= n.
+static size_t round_up_pow2(size_t n) {
+  size_t p = 1;
+  while (p < n && p <= SIZE_MAX / 2) p <<= 1;
+  return p;
+}
+
+// True if a and b name the same file (the same path given twice, a hard link).
+static bool same_file(const std::string& a, const std::string& b) {
+  if (a == b) return true;
+#if defined(_WIN32)
+  return false;
+#else
+  struct stat sa, sb;
+  return stat(a.c_str(), &sa) == 0 && stat(b.c_str(), &sb) == 0 &&
+         sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+#endif
+}
+
+static int corpus_report(const std::vector<Input>& files, size_t limit, size_t max_len,
+                         const CorpusOptions& opts) {
+  struct Entry {
+    size_t size = 0;
+    uint64_t hash = 0;
+    bool ok = false;
+  };
+  std::vector<Entry> entries(limit);
+  size_t nthreads = opts.threads > 0 ? static_cast<size_t>(opts.threads)
+                                     : std::max(1u, std::thread::hardware_concurrency());
+  nthreads = std::max<size_t>(1, std::min(nthreads, limit));
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < nthreads; ++t) {
+    threads.emplace_back([&] {
+      InputLoader loader;
+      for (size_t i = next++; i < limit; i = next++) {
+        if (!loader.load(files[i], SIZE_MAX)) continue;
+        entries[i] = {loader.size(), input_hash(loader.data(), loader.size()), true};
+        loader.release();
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+
+  // Duplicates sort next to the copy that stays, which comes first.
+  std::vector<size_t> order;
+  for (size_t i = 0; i < limit; ++i) {
+    if (entries[i].ok) order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    const Entry &ea = entries[a], &eb = entries[b];
+    if (ea.size != eb.size) return ea.size < eb.size;
+    if (ea.hash != eb.hash) return ea.hash < eb.hash;
+    return a < b;
+  });
+  std::vector<size_t> unique;                    // by size
+  std::vector<std::pair<size_t, size_t>> dups;  // (duplicate, copy that stays)
+  size_t groups = 0;
+  uint64_t total_bytes = 0, dup_bytes = 0;
+  uint64_t hist[65] = {};  // [0]: empty inputs, [b]: sizes in [2^(b-1), 2^b)
+  for (size_t k = 0; k < order.size(); ++k) {
+    const Entry& e = entries[order[k]];
+    total_bytes += e.size;
+    ++hist[e.size ? 64 - __builtin_clzll(static_cast<unsigned long long>(e.size)) : 0];
+    const Entry* prev = k ? &entries[order[k - 1]] : nullptr;
+    if (prev && prev->size == e.size && prev->hash == e.hash) {
+      if (dups.empty() || dups.back().second != unique.back()) ++groups;
+      dups.push_back({order[k], unique.back()});
+      dup_bytes += e.size;
+    } else {
+      unique.push_back(order[k]);
+    }
+  }
+
+  fprintf(stderr, "==corpus== %zu inputs, %s", order.size(),
+          format_bytes(static_cast<double>(total_bytes)).c_str());
+  if (order.size() < limit) fprintf(stderr, " (%zu unreadable)", limit - order.size());
+  fprintf(stderr, "\n==corpus== %zu unique", unique.size());
+  if (groups) {
+    fprintf(stderr, ", %zu duplicate copies of %zu of them (%s)", dups.size(), groups,
+            format_bytes(static_cast<double>(dup_bytes)).c_str());
+  }
+  fprintf(stderr, "\n");
+  if (unique.empty()) return 1;
+
+  const uint64_t peak = *std::max_element(hist, hist + 65);
+  fprintf(stderr, "==corpus== sizes:\n");
+  for (size_t b = 0; b < 65; ++b) {
+    if (!hist[b]) continue;
+    const uint64_t lo = b ? uint64_t(1) << (b - 1) : 0, hi = b ? lo * 2 - 1 : 0;
+    std::string range = format_bytes(static_cast<double>(lo));
+    if (hi > lo) range += " - " + format_bytes(static_cast<double>(hi));
+    std::string bar(static_cast<size_t>((hist[b] * 40 + peak - 1) / peak), '#');
+    fprintf(stderr, "==corpus==   %21s %9llu  %s\n", range.c_str(),
+            static_cast<unsigned long long>(hist[b]), bar.c_str());
+  }
+
+  // Room for the mutators to grow a typical input, without the few largest
+  // inputs setting the length every exec may use.
+  auto pct = [&](double q) {
+    return entries[unique[static_cast<size_t>(q * static_cast<double>(unique.size() - 1))]].size;
+  };
+  const size_t p50 = pct(0.50), p90 = pct(0.90), p99 = pct(0.99);
+  const size_t largest = entries[unique.back()].size;
+  const size_t suggest = round_up_pow2(std::max<size_t>({64, 2 * p90, p99}));
+  size_t longer = 0;
+  for (size_t i : unique) longer += entries[i].size > suggest;
+  fprintf(stderr, "==corpus== unique sizes: p50 %s, p90 %s, p99 %s, max %s\n",
+          format_bytes(static_cast<double>(p50)).c_str(), format_bytes(static_cast<double>(p90)).c_str(),
+          format_bytes(static_cast<double>(p99)).c_str(), format_bytes(static_cast<double>(largest)).c_str());
+  fprintf(stderr, "==corpus== suggested max length %zu, max(2 x p90, p99) rounded up to a power of two",
+          suggest);
+  if (longer) fprintf(stderr, " (truncates %zu unique inputs)", longer);
+  fprintf(stderr, ":\n");
+  fprintf(stderr, "==corpus==   libFuzzer   -max_len=%zu\n", suggest);
+  fprintf(stderr, "==corpus==   AFL++       afl-fuzz -G %zu, AFL_DRIVER_MAX_LEN=%zu\n", suggest, suggest);
+  fprintf(stderr, "==corpus==   Mayhemfile  max_length: %zu\n", suggest);
+
+  if (opts.stats) {
+    // One run each in corpus order, which is the order a replay sees them in.
+    std::vector<size_t> runs(unique);
+    std::sort(runs.begin(), runs.end());
+    std::vector<std::pair<int64_t, size_t>> timed;  // (ns, input)
+    int64_t total_ns = 0;
+#if !defined(_WIN32)
+    // In forked workers, so inputs that crash or time out are listed rather
+    // than ending the report.
+    std::vector<Input> run_files;
+    for (size_t i : runs) run_files.push_back(files[i]);
+    const size_t times_len = sizeof(int64_t) * runs.size();
+    void* shm = mmap(nullptr, times_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shm == MAP_FAILED) {
+      std::perror("mmap");
+      return 1;
+    }
+    ForkOptions fork_opts;
+    fork_opts.jobs = static_cast<int>(std::min(nthreads, runs.size()));
+    fork_opts.times = static_cast<int64_t*>(shm);
+    std::fill(fork_opts.times, fork_opts.times + runs.size(), -1);
+    std::vector<Crash> crashes;
+    if (fork_workers(run_files, runs.size(), max_len, fork_opts, crashes) < 0) return 1;
+    for (size_t k = 0; k < runs.size(); ++k) {
+      const int64_t ns = fork_opts.times[k];
+      if (ns < 0) continue;  // unreadable, or it crashed
+      timed.push_back({ns, runs[k]});
+      total_ns += ns;
+    }
+    munmap(shm, times_len);
+#else
+    InputLoader loader;
+    start_watchdog();
+    for (size_t i : runs) {
+      if (!loader.load(files[i], max_len)) continue;
+      const int64_t t0 = now_ns();
+      run_one(files[i].path.c_str(), loader.data(), loader.size());
+      const int64_t ns = now_ns() - t0;
+      loader.release();
+      timed.push_back({ns, i});
+      total_ns += ns;
+    }
+#endif
+    std::sort(timed.begin(), timed.end(), [](const std::pair<int64_t, size_t>& a,
+                                            const std::pair<int64_t, size_t>& b) {
+      return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    if (timed.size() > opts.top) timed.resize(opts.top);
+    fprintf(stderr, "==corpus== one run of each unique input: %s; slowest:\n",
+            format_ns(static_cast<double>(total_ns)).c_str());
+    for (const auto& t : timed) {
+      fprintf(stderr, "==corpus==   %10s %10s  %s\n", format_ns(static_cast<double>(t.first)).c_str(),
+              format_bytes(static_cast<double>(entries[t.second].size)).c_str(),
+              files[t.second].path.c_str());
+    }
+#if !defined(_WIN32)
+    if (!crashes.empty()) {
+      fprintf(stderr, "==corpus== %zu unique inputs crashed or timed out:\n", crashes.size());
+      for (const auto& c : crashes) {
+        fprintf(stderr, "==corpus==   %-21s %s\n", describe_status(c.status).c_str(),
+                c.input == kNoInput ? "(between inputs)" : run_files[c.input].path.c_str());
+      }
+    }
+#endif
+  }
+
+  if (opts.dedup) {
+    InputLoader keep, dup;
+    size_t removed = 0, in_packs = 0;
+    uint64_t removed_bytes = 0;
+    for (const auto& d : dups) {
+      const Input &in = files[d.first], &kept = files[d.second];
+      if (in.data) {
+        ++in_packs;
+        continue;
+      }
+      if (!kept.data && same_file(in.path, kept.path)) continue;
+      if (!keep.load(kept, SIZE_MAX) || !dup.load(in, SIZE_MAX)) continue;
+      const bool same = keep.size() == dup.size() &&
+                        (keep.size() == 0 || std::memcmp(keep.data(), dup.data(), keep.size()) == 0);
+      keep.release();
+      dup.release();
+      if (!same) continue;  // a hash collision
+      if (std::remove(in.path.c_str()) != 0) {
+        fprintf(stderr, "can't remove %s: %s\n", in.path.c_str(), strerror(errno));
+        continue;
+      }
+      ++removed;
+      removed_bytes += entries[d.first].size;
+    }
+    fprintf(stderr, "==corpus== dedup: removed %zu duplicate files (%s)", removed,
+            format_bytes(static_cast<double>(removed_bytes)).c_str());
+    if (in_packs) fprintf(stderr, ", left %zu inside packs", in_packs);
+    fprintf(stderr, "\n");
+  }
+  return 0;
+}
+
+// -------------------- Crash minimization (-minimize=FILE) --------------------
+// Delta debugging (ddmin) on a crashing input, for the engines that lack
+// libFuzzer's -minimize_crash. The input is cut into n chunks and every
+// complement (the input without one chunk) is tried. The first complement
+// that still crashes the same way replaces the input; if none does, n
+// doubles, until no single byte can be removed. Candidates run in -jobs=N
+// forked workers (default: all cores). A worker takes candidates from shared
+// memory and stays alive while they pass, so a fork is only paid after a
+// crash. Up to N complements run at once and the lowest-numbered one that
+// reproduces wins, so the result doesn't depend on N.
+//
+// "The same way" means the same signature: the sanitizer's bug type (or the
+// wait status when there is no report) and the top -minimize_frames=N
+// (default 3) PCs of the crashing stack, not counting frames in libc and the
+// sanitizer and C++ runtimes. All workers fork from this process, so their
+// PCs compare as they are. The stack comes from the sanitizer report on the
+// worker's stderr or, for signals no sanitizer handles, from the driver's
+// own handler. The result is written to -exact_artifact_path=PATH (default
+// FILE.min).
+#if !defined(_WIN32)
+static const int64_t kMinimizeTimeoutNs = 10000000000LL;  // when no -timeout is given
+static const size_t kMinimizeLogLimit = 256 * 1024;       // stderr kept per candidate
+
+struct CrashSignature {
+  std::string type;
+  std::vector<uintptr_t> pcs;
+  std::vector<std::string> frames;  // the report's lines for pcs
+
+  bool operator==(const CrashSignature& o) const { return type == o.type && pcs == o.pcs; }
+};
+
+#if defined(__GLIBC__)
+// Prints the crashing stack in the sanitizers' "#N 0xPC" form, then dies of
+// the same signal.
+static void on_minimize_fatal_signal(int sig) {
+  void* pcs[64];
+  int n = backtrace(pcs, 64);
+  write_str("==minimize== fatal signal ");
+  write_u64(static_cast<uint64_t>(sig));
+  write_str("\n");
+  for (int i = 1; i < n; ++i) {  // frame 0 is this handler
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    *--p = '\0';
+    *--p = '\n';
+    uintptr_t v = reinterpret_cast<uintptr_t>(pcs[i]);
+    do {
+      *--p = "0123456789abcdef"[v & 15];
+      v >>= 4;
+    } while (v);
+    write_str("    #");
+    write_u64(static_cast<uint64_t>(i - 1));
+    write_str(" 0x");
+    write_str(p);
+  }
+  raise(sig);
+}
+
+static void minimize_catch_signals() {
+  void* warm[1];
+  backtrace(warm, 1);  // loads the unwinder now rather than in the handler
+  struct sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_minimize_fatal_signal;
+  sa.sa_flags = SA_RESETHAND | SA_NODEFER;
+  sigemptyset(&sa.sa_mask);
+  for (int sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+    // A sanitizer's handler stays; its report has the stack.
+    struct sigaction old;
+    if (sigaction(sig, nullptr, &old) == 0 && old.sa_handler == SIG_DFL) sigaction(sig, &sa, nullptr);
+  }
+}
+#else
+static void minimize_catch_signals() {}
+#endif
+
+// Address ranges of the loaded objects, and whether each is a runtime
+// library whose frames don't tell crashes apart.
+struct ModuleRange {
+  uintptr_t begin, end;
+  bool runtime;
+};
+
+static bool is_runtime_library(const char* path) {
+  const char* base = std::strrchr(path, '/');
+  base = base ? base + 1 : path;
+  static const char* const kRuntimes[] = {"libasan", "libubsan", "libtsan", "libmsan", "liblsan",
+                                          "libclang_rt", "libc.", "libc-", "libm.", "libm-",
+                                          "libstdc++", "libc++", "libgcc_s", "libpthread", "ld-"};
+  for (const char* r : kRuntimes) {
+    if (std::strncmp(base, r, std::strlen(r)) == 0) return true;
+  }
+  return false;
+}
+
+#if defined(__linux__)
+static int add_module_ranges(struct dl_phdr_info* info, size_t, void* out) {
+  auto& mods = *static_cast<std::vector<ModuleRange>*>(out);
+  const bool runtime = info->dlpi_name && is_runtime_library(info->dlpi_name);
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+    if (ph.p_type != PT_LOAD) continue;
+    uintptr_t begin = info->dlpi_addr + ph.p_vaddr;
+    mods.push_back({begin, begin + ph.p_memsz, runtime});
+  }
+  return 0;
+}
+#endif
+
+static bool in_runtime_library(const std::vector<ModuleRange>& mods, uintptr_t pc) {
+  for (const auto& m : mods) {
+    if (pc >= m.begin && pc < m.end) return m.runtime;
+  }
+  return false;
+}
+
+// Reads a signature from what a crashed worker wrote to stderr.
+static CrashSignature crash_signature(const std::string& log, int status, size_t max_frames,
+                                      const std::vector<ModuleRange>& mods) {
+  CrashSignature sig;
+  // The RSS check fires wherever the input happens to be, so its stack says
+  // nothing.
+  if (log.find("==driver== out-of-memory") != std::string::npos) {
+    sig.type = "out-of-memory";
+    return sig;
+  }
+  bool in_stack = false;
+  for (size_t pos = 0; pos < log.size();) {
+    size_t eol = log.find('\n', pos);
+    if (eol == std::string::npos) eol = log.size();
+    const std::string line = log.substr(pos, eol - pos);
+    pos = eol + 1;
+    size_t at;
+    if (sig.type.empty() && (at = line.find("ERROR: ")) != std::string::npos &&
+        (at = line.find("Sanitizer: ", at)) != std::string::npos) {
+      // "==1==ERROR: AddressSanitizer: heap-buffer-overflow on address ..."
+      at += 11;
+      sig.type = line.substr(at, line.find(' ', at) - at);
+      continue;
+    }
+    if (sig.type.empty() && (at = line.find(": runtime error: ")) != std::string::npos) {
+      // "file.cpp:12:5: runtime error: index 9 out of bounds for type 'int [4]'"
+      // -> "file.cpp:12:5: runtime error: index out of bounds", leaving out the
+      // values, which differ between candidates, as triage does
+      std::string msg = line.substr(at + 17);
+      for (const char* cut : {" for type ", " of type "}) msg = msg.substr(0, msg.find(cut));
+      sig.type = line.substr(0, at) + ": runtime error:";
+      std::string word;
+      for (size_t k = 0; k <= msg.size(); ++k) {
+        if (k < msg.size() && msg[k] != ' ') {
+          word += msg[k];
+          continue;
+        }
+        if (!word.empty() && word.find_first_of("0123456789") == std::string::npos) sig.type += " " + word;
+        word.clear();
+      }
+      continue;
+    }
+    // "    #3 0x55d3c0a1b2c3 in ..." (frames of the first stack only)
+    size_t h = line.find_first_not_of(' ');
+    size_t d = h == std::string::npos ? h : h + 1;
+    while (d != std::string::npos && d < line.size() && line[d] >= '0' && line[d] <= '9') ++d;
+    if (h == std::string::npos || line[h] != '#' || d == h + 1 || line.compare(d, 3, " 0x") != 0) {
+      if (in_stack) break;
+      continue;
+    }
+    in_stack = true;
+    uintptr_t pc = static_cast<uintptr_t>(std::strtoull(line.c_str() + d + 3, nullptr, 16));
+    if (in_runtime_library(mods, pc) || sig.pcs.size() >= max_frames) continue;
+    sig.pcs.push_back(pc);
+    sig.frames.push_back(line.substr(h));
+  }
+  if (sig.type.empty()) sig.type = describe_status(status);
+  return sig;
+}
+
+static bool read_exact(int fd, void* buf, size_t n) {
+  uint8_t* p = static_cast<uint8_t*>(buf);
+  while (n > 0) {
+    ssize_t r = read(fd, p, n);
+    if (r == -1 && errno == EINTR) continue;
+    if (r <= 0) return false;
+    p += r;
+    n -= static_cast<size_t>(r);
+  }
+  return true;
+}
+
+class CrashMinimizer {
+ public:
+  struct Outcome {
+    bool crashed = false;
+    CrashSignature sig;
+    int64_t ns = 0;  // from handing the candidate over to its result
+  };
+
+  CrashMinimizer(const char* label, size_t workers, size_t slot_size, size_t max_frames)
+      : label_(label), workers_(workers), slot_size_(std::max<size_t>(slot_size, 1)),
+        max_frames_(max_frames) {
+    shm_len_ = slot_size_ * workers;
+    void* p = mmap(nullptr, shm_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      std::perror("mmap");
+      return;
+    }
+    shm_ = static_cast<uint8_t*>(p);
+#if defined(__linux__)
+    dl_iterate_phdr(add_module_ranges, &mods_);
+#endif
+    signal(SIGPIPE, SIG_IGN);  // a worker that died before reading its candidate
+  }
+
+  ~CrashMinimizer() {
+    for (auto& w : workers_) close_worker(w, true);
+    if (shm_) munmap(shm_, shm_len_);
+  }
+
+  bool ok() const { return shm_ != nullptr; }
+  size_t workers() const { return workers_.size(); }
+
+  // Runs cands[i] on worker i, all at once.
+  void run(const std::vector<const std::vector<uint8_t>*>& cands, std::vector<Outcome>& out) {
+    out.assign(cands.size(), Outcome());
+    std::vector<int64_t> start(cands.size(), 0);
+    size_t busy = 0;
+    for (size_t i = 0; i < cands.size(); ++i) {
+      Worker& w = workers_[i];
+      if (w.pid == -1 && !spawn(i)) continue;  // counts as passing
+      std::memcpy(shm_ + i * slot_size_, cands[i]->data(), cands[i]->size());
+      uint64_t n = cands[i]->size();
+      w.log.clear();
+      start[i] = now_ns();
+      // A short write means the worker is gone; the poll below sees that.
+      ssize_t rc = write(w.cmd, &n, sizeof(n));
+      (void)rc;
+      w.busy = true;
+      ++busy;
+    }
+    while (busy > 0) {
+      std::vector<pollfd> fds;
+      std::vector<size_t> owner;
+      for (size_t i = 0; i < cands.size(); ++i) {
+        if (!workers_[i].busy) continue;
+        if (workers_[i].err != -1) {
+          fds.push_back({workers_[i].err, POLLIN, 0});
+          owner.push_back(i);
+        }
+        fds.push_back({workers_[i].resp, POLLIN, 0});
+        owner.push_back(i);
+      }
+      if (poll(fds.data(), fds.size(), -1) == -1) {
+        if (errno == EINTR) continue;
+        std::perror("poll");
+        return;
+      }
+      for (size_t k = 0; k < fds.size(); ++k) {
+        Worker& w = workers_[owner[k]];
+        if (!fds[k].revents || !w.busy) continue;
+        if (fds[k].fd == w.err) {
+          drain(w, false);
+          continue;
+        }
+        char done;
+        ssize_t r;
+        do {
+          r = read(w.resp, &done, 1);
+        } while (r == -1 && errno == EINTR);
+        Outcome& o = out[owner[k]];
+        o.ns = now_ns() - start[owner[k]];
+        w.busy = false;
+        --busy;
+        if (r == 1) continue;
+        // The worker died: the rest of its report, then its status.
+        drain(w, true);
+        int status = 0;
+        while (waitpid(w.pid, &status, 0) == -1 && errno == EINTR) {
+        }
+        w.pid = -1;
+        o.crashed = true;
+        o.sig = crash_signature(w.log, status, max_frames_, mods_);
+        close_worker(w, false);
+      }
+    }
+  }
+
+  uint64_t forks = 0;
+
+ private:
+  struct Worker {
+    pid_t pid = -1;
+    int cmd = -1, resp = -1, err = -1;  // this side's ends of the worker's pipes
+    std::string log;                   // what the current candidate wrote to stderr
+    bool busy = false;
+  };
+
+  bool spawn(size_t i) {
+    int cmd[2], resp[2], err[2];
+    if (pipe(cmd) == -1) return false;
+    if (pipe(resp) == -1) {
+      close(cmd[0]);
+      close(cmd[1]);
+      return false;
+    }
+    if (pipe(err) == -1) {
+      close(cmd[0]);
+      close(cmd[1]);
+      close(resp[0]);
+      close(resp[1]);
+      return false;
+    }
+    std::fflush(nullptr);
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(cmd[1]);
+      close(resp[0]);
+      close(err[0]);
+      signal(SIGPIPE, SIG_DFL);
+      dup2(err[1], STDERR_FILENO);
+      close(err[1]);
+      int null = open("/dev/null", O_WRONLY);
+      if (null != -1) {
+        dup2(null, STDOUT_FILENO);
+        close(null);
+      }
+#if FUZZ_HAS_SANITIZER
+      if (__sanitizer_set_report_fd) __sanitizer_set_report_fd(reinterpret_cast<void*>(STDERR_FILENO));
+#endif
+      minimize_catch_signals();
+      start_watchdog();
+      const uint8_t* slot = shm_ + i * slot_size_;
+      for (;;) {
+        uint64_t n = 0;
+        if (!read_exact(cmd[0], &n, sizeof(n))) _exit(0);
+        // An exact-size copy, so reads past the end are caught
+        std::vector<uint8_t> data(slot, slot + n);
+        run_one(label_, data.data(), data.size());
+        char done = 1;
+        if (write(resp[1], &done, 1) != 1) _exit(0);
+      }
+    }
+    close(cmd[0]);
+    close(resp[1]);
+    close(err[1]);
+    if (pid == -1) {
+      std::perror("fork");
+      close(cmd[1]);
+      close(resp[0]);
+      close(err[0]);
+      return false;
+    }
+    ++forks;
+    Worker& w = workers_[i];
+    w.pid = pid;
+    w.cmd = cmd[1];
+    w.resp = resp[0];
+    w.err = err[0];
+    return true;
+  }
+
+  // Appends the worker's stderr to its log: what is there now, or everything
+  // up to EOF.
+  void drain(Worker& w, bool to_eof) {
+    char buf[4096];
+    while (w.err != -1) {
+      ssize_t n = read(w.err, buf, sizeof(buf));
+      if (n == -1 && errno == EINTR) continue;
+      if (n <= 0) {
+        close(w.err);
+        w.err = -1;
+        break;
+      }
+      if (w.log.size() < kMinimizeLogLimit) w.log.append(buf, static_cast<size_t>(n));
+      if (!to_eof) break;
+    }
+  }
+
+  void close_worker(Worker& w, bool kill_it) {
+    if (kill_it && w.pid != -1) {
+      kill(w.pid, SIGKILL);
+      while (waitpid(w.pid, nullptr, 0) == -1 && errno == EINTR) {
+      }
+      w.pid = -1;
+    }
+    for (int* fd : {&w.cmd, &w.resp, &w.err}) {
+      if (*fd != -1) close(*fd);
+      *fd = -1;
+    }
+  }
+
+  const char* label_;
+  std::vector<Worker> workers_;
+  size_t slot_size_;
+  size_t max_frames_;
+  std::vector<ModuleRange> mods_;
+  uint8_t* shm_ = nullptr;
+  size_t shm_len_ = 0;
+};
+
+static int minimize_crash(const std::string& path, int jobs, size_t max_frames,
+                          std::string out_path, size_t max_len) {
+  InputLoader loader;
+  if (!loader.load_file(path.c_str(), max_len)) return 1;
+  std::vector<uint8_t> best(loader.data(), loader.data() + loader.size());
+  loader.release();
+  const size_t original = best.size();
+  if (out_path.empty()) out_path = path + ".min";
+  if (g_timeout_ns <= 0) g_timeout_ns = kMinimizeTimeoutNs;
+
+  size_t workers = jobs > 0 ? static_cast<size_t>(jobs) : std::max(1u, std::thread::hardware_concurrency());
+  CrashMinimizer m(path.c_str(), workers, best.size(), max_frames);
+  if (!m.ok()) return 1;
+  const int64_t t0 = now_ns();
+  std::vector<CrashMinimizer::Outcome> res;
+  m.run({&best}, res);
+  if (!res[0].crashed) {
+    fprintf(stderr, "==minimize== %s doesn't crash; nothing to minimize\n", path.c_str());
+    return 1;
+  }
+  const CrashSignature want = res[0].sig;
+  const int64_t original_ns = res[0].ns;
+  int64_t best_ns = original_ns;
+  fprintf(stderr, "==minimize== %s (%zu bytes): %s\n", path.c_str(), original, want.type.c_str());
+  for (const auto& f : want.frames) fprintf(stderr, "==minimize==   %s\n", f.c_str());
+
+  uint64_t tried = 0, reproduced = 0, other = 0;
+  std::vector<std::vector<uint8_t>> wave;
+  std::vector<const std::vector<uint8_t>*> ptrs;
+  size_t n = 2;
+  while (!best.empty()) {
+    n = std::min(n, best.size());
+    size_t found = SIZE_MAX;
+    for (size_t first = 0; first < n && found == SIZE_MAX; first += m.workers()) {
+      const size_t count = std::min(m.workers(), n - first);
+      wave.resize(count);
+      ptrs.clear();
+      for (size_t k = 0; k < count; ++k) {
+        // best without chunk first + k
+        const size_t begin = best.size() * (first + k) / n, end = best.size() * (first + k + 1) / n;
+        wave[k].assign(best.begin(), best.begin() + static_cast<std::ptrdiff_t>(begin));
+        wave[k].insert(wave[k].end(), best.begin() + static_cast<std::ptrdiff_t>(end), best.end());
+        ptrs.push_back(&wave[k]);
+      }
+      m.run(ptrs, res);
+      for (size_t k = 0; k < count; ++k) {
+        ++tried;
+        if (!res[k].crashed) continue;
+        if (!(res[k].sig == want)) {
+          ++other;
+          continue;
+        }
+        ++reproduced;
+        if (found == SIZE_MAX) {
+          found = k;
+          best_ns = res[k].ns;
+        }
+      }
+    }
+    if (found != SIZE_MAX) {
+      best.swap(wave[found]);
+      n = std::max<size_t>(n - 1, 2);
+      continue;
+    }
+    if (n >= best.size()) break;
+    n = std::min(best.size(), n * 2);
+    fprintf(stderr, "==minimize== %zu bytes, trying %zu chunks\n", best.size(), n);
+  }
+  const double secs = static_cast<double>(now_ns() - t0) / 1e9;
+
+  FILE* out = std::fopen(out_path.c_str(), "wb");
+  bool ok = out && std::fwrite(best.data(), 1, best.size(), out) == best.size();
+  if (out) ok = (std::fclose(out) == 0) && ok;
+  if (!ok) {
+    fprintf(stderr, "can't write %s: %s\n", out_path.c_str(), strerror(errno));
+    return 1;
+  }
+  fprintf(stderr, "==minimize== %zu -> %zu bytes in %.2f s, written to %s\n", original, best.size(),
+          secs, out_path.c_str());
+  fprintf(stderr, "==minimize== %llu candidates on %zu workers (%.0f/s): %llu reproduced, "
+                  "%llu crashed differently, %llu passed; %llu forks\n",
+          static_cast<unsigned long long>(tried), m.workers(),
+          secs > 0 ? static_cast<double>(tried) / secs : 0, static_cast<unsigned long long>(reproduced),
+          static_cast<unsigned long long>(other),
+          static_cast<unsigned long long>(tried - reproduced - other),
+          static_cast<unsigned long long>(m.forks));
+  fprintf(stderr, "==minimize== time to crash: %s (original: %s)\n",
+          format_ns(static_cast<double>(best_ns)).c_str(), format_ns(static_cast<double>(original_ns)).c_str());
+  return 0;
+}
+#endif
+
+// Optional: ensure sanitizer reports get flushed
+#if FUZZ_HAS_SANITIZER
+static void on_sanitizer_death() { std::fflush(nullptr); }
+#endif
+
+// -------------------- Driver --------------------
+int main(int argc, char** argv) {
+  // Parse simple flags we support (like afl_driver):
+  //   -runs=N     limit number of testcase invocations
+  //   -persistent_iters=N  AFL++ persistent loop count before re-forking
+  //   -jobs=N     replay inputs in N forked workers (alias: -workers=N)
+  //   -keep_going=1  run inputs in forked batches and carry on after crashes
+  //   -batch=N    inputs per forked child with -keep_going (default 32)
+  //   -timeout=MS  abort with exit code 70 if one input runs longer than MS
+  //   -report_slow_inputs=MS  log inputs that take longer than MS
+  //   -rss_limit_mb=MB  abort (out-of-memory crash) once the peak RSS passes MB
+  //   -malloc_limit_mb=MB  abort on a single allocation above MB (default: -rss_limit_mb)
+  //   -malloc_stats=1  print allocations, bytes and peak RSS per input
+  //   -bench=1    time the harness over the corpus and report exec/s and latency
+  //   -bench_seconds=S / -bench_iters=N  benchmark length (default 10 s)
+  //   -bench_top=N  number of slowest inputs to list (default 10)
+  //   -bench_json=FILE  also write the results as JSON ("-" for stdout)
+  //   -threads=N  call the harness from up to N threads at once and report scaling
+  //   -thread_shards=1  give each stress thread its own slice of the corpus
+  //   -stress_seconds=S  length of each -threads step (default 2 s)
+  //   -pack=OUT   write the inputs to the corpus pack OUT and exit
+  //   -minimize_corpus=OUTDIR  copy a smallest edge-preserving subset of the inputs
+  //               to OUTDIR (needs a trace-pc-guard build)
+  //   -corpus_stats=1  report sizes, duplicates, max_len suggestions and the
+  //               slowest inputs (-bench_top of them), hashing on -jobs threads
+  //   -dedup=1    report as -corpus_stats without timing and delete duplicate files
+  //   -minimize=FILE  shrink the crashing input FILE on -jobs workers, keeping its
+  //               crash signature; writes FILE.min (or -exact_artifact_path=PATH)
+  //   -minimize_frames=N  stack frames in the signature (default 3)
+  //   -sort_by_size=1  replay the smallest inputs first
+  //   -max_files=N  stop enumerating inputs after N
+  //   -replay_cache=DIR  skip inputs that already passed against this binary
+  //   -force=1 (or --force)  ignore the replay cache, but keep recording
+  // Everything else is treated as a path (file, directory or corpus pack).
+  int runs = -1;
+  unsigned persistent_iters = 10000;
+  int jobs = 0;  // 0 = not given; replay runs in-process, analytics use all cores
+  bool keep_going = false;
+  size_t batch = 32;
+  bool bench = false;
+  BenchOptions bench_opts;
+  StressOptions stress_opts;
+  std::string pack_out;
+  std::string minimize_dir;
+  CorpusOptions corpus_opts;
+  std::string crash_file;
+  std::string artifact_path;
+  size_t minimize_frames = 3;
+  bool sort_by_size = false;
+  size_t max_files = 0;
+  std::string replay_cache_dir;
+  bool force = false;
+  long long malloc_limit_mb = -1;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "-runs=", 6) == 0) {
+      runs = std::atoi(argv[i] + 6);
+    } else if (std::strncmp(argv[i], "-persistent_iters=", 18) == 0) {
+      persistent_iters = static_cast<unsigned>(std::strtoul(argv[i] + 18, nullptr, 10));
+      if (persistent_iters == 0) persistent_iters = 1;
+    } else if (std::strncmp(argv[i], "-jobs=", 6) == 0) {
+      jobs = std::max(1, std::atoi(argv[i] + 6));
+    } else if (std::strncmp(argv[i], "-workers=", 9) == 0) {
+      jobs = std::max(1, std::atoi(argv[i] + 9));
+    } else if (std::strncmp(argv[i], "-keep_going=", 12) == 0) {
+      keep_going = std::atoi(argv[i] + 12) != 0;
+    } else if (std::strncmp(argv[i], "-batch=", 7) == 0) {
+      batch = std::max<size_t>(1, std::strtoul(argv[i] + 7, nullptr, 10));
+    } else if (std::strncmp(argv[i], "-timeout=", 9) == 0) {
+      g_timeout_ns = std::strtoll(argv[i] + 9, nullptr, 10) * 1000000;
+    } else if (std::strncmp(argv[i], "-report_slow_inputs=", 20) == 0) {
+      g_slow_ns = std::strtoll(argv[i] + 20, nullptr, 10) * 1000000;
+    } else if (std::strncmp(argv[i], "-rss_limit_mb=", 14) == 0) {
+      g_rss_limit_mb = std::strtoull(argv[i] + 14, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-malloc_limit_mb=", 17) == 0) {
+      malloc_limit_mb = std::strtoll(argv[i] + 17, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-malloc_stats=", 14) == 0) {
+      g_malloc_stats = std::atoi(argv[i] + 14) != 0;
+    } else if (std::strncmp(argv[i], "-bench=", 7) == 0) {
+      bench = std::atoi(argv[i] + 7) != 0;
+    } else if (std::strncmp(argv[i], "-bench_seconds=", 15) == 0) {
+      bench_opts.seconds = std::strtod(argv[i] + 15, nullptr);
+    } else if (std::strncmp(argv[i], "-bench_iters=", 13) == 0) {
+      bench_opts.iters = std::strtoull(argv[i] + 13, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-bench_top=", 11) == 0) {
+      bench_opts.top = std::strtoul(argv[i] + 11, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-bench_json=", 12) == 0) {
+      bench_opts.json_path = argv[i] + 12;
+    } else if (std::strncmp(argv[i], "-threads=", 9) == 0) {
+      stress_opts.threads = std::max(0, std::atoi(argv[i] + 9));
+    } else if (std::strncmp(argv[i], "-thread_shards=", 15) == 0) {
+      stress_opts.shards = std::atoi(argv[i] + 15) != 0;
+    } else if (std::strncmp(argv[i], "-stress_seconds=", 16) == 0) {
+      stress_opts.seconds = std::strtod(argv[i] + 16, nullptr);
+    } else if (std::strncmp(argv[i], "-minimize_corpus=", 17) == 0) {
+      minimize_dir = argv[i] + 17;
+    } else if (std::strncmp(argv[i], "-corpus_stats=", 14) == 0) {
+      corpus_opts.stats = std::atoi(argv[i] + 14) != 0;
+    } else if (std::strncmp(argv[i], "-dedup=", 7) == 0) {
+      corpus_opts.dedup = std::atoi(argv[i] + 7) != 0;
+    } else if (std::strncmp(argv[i], "-minimize=", 10) == 0) {
+      crash_file = argv[i] + 10;
+    } else if (std::strncmp(argv[i], "-minimize_frames=", 17) == 0) {
+      minimize_frames = std::strtoul(argv[i] + 17, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-exact_artifact_path=", 21) == 0) {
+      artifact_path = argv[i] + 21;
+    } else if (std::strncmp(argv[i], "-pack=", 6) == 0) {
+      pack_out = argv[i] + 6;
+    } else if (std::strncmp(argv[i], "-sort_by_size=", 14) == 0) {
+      sort_by_size = std::atoi(argv[i] + 14) != 0;
+    } else if (std::strncmp(argv[i], "-max_files=", 11) == 0) {
+      max_files = std::strtoul(argv[i] + 11, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-replay_cache=", 14) == 0) {
+      replay_cache_dir = argv[i] + 14;
+    } else if (std::strncmp(argv[i], "-force=", 7) == 0) {
+      force = std::atoi(argv[i] + 7) != 0;
+    } else if (std::strcmp(argv[i], "--force") == 0) {
+      force = true;
+    } else {
+      paths.emplace_back(argv[i]);
+    }
+  }
+
+  // Environment knobs
+  size_t max_len = 1 << 20; // 1 MiB default
+  if (const char* ml = std::getenv("AFL_DRIVER_MAX_LEN")) {
+    long v = std::strtol(ml, nullptr, 10);
+    if (v > 0) max_len = static_cast<size_t>(v);
+  }
+
+  // Packing doesn't run the harness.
+  if (!pack_out.empty()) {
+    return write_pack(paths, pack_out);
+  }
+
+#if FUZZ_HAS_SANITIZER
+  // Duplicate sanitizer reports to file if requested (compatible with afl_driver)
+  const char* dup = std::getenv("AFL_DRIVER_STDERR_DUPLICATE_FILENAME");
+  if (dup && __sanitizer_set_report_path) __sanitizer_set_report_path(dup);
+  if (__sanitizer_set_death_callback) __sanitizer_set_death_callback(&on_sanitizer_death);
+  // Otherwise prefer fd routing if available (setting an fd would override the path)
+  if (!dup && __sanitizer_set_report_fd) {
+    __sanitizer_set_report_fd(reinterpret_cast<void*>(fileno(stderr)));
+  }
+#endif
+
+  // Like libFuzzer, the allocation limit follows the RSS limit unless set;
+  // only an explicit request is worth a warning when it can't be honored.
+  bool malloc_flags_set = g_malloc_stats || malloc_limit_mb >= 0;
+  if (malloc_limit_mb < 0) malloc_limit_mb = static_cast<long long>(g_rss_limit_mb);
+  g_malloc_limit = static_cast<size_t>(malloc_limit_mb) << 20;
+  if ((g_malloc_stats || g_malloc_limit) && !start_malloc_tracking()) {
+    if (malloc_flags_set) {
+      fprintf(stderr, "==driver== allocations can't be tracked in this build (needs a sanitizer or "
+                      "-DFUZZ_INTERPOSE_MALLOC=1); ignoring -malloc_stats and -malloc_limit_mb\n");
+    }
+    g_malloc_stats = false;
+    g_malloc_limit = 0;
+  }
+
+#if !defined(_WIN32)
+  profile_catch_crashes();
+#endif
+
+  // Allow user harness init
+  if (LLVMFuzzerInitialize) {
+    (void)LLVMFuzzerInitialize(&argc, &argv);
+  }
+
+  // The minimizer works on its one input, in forked workers.
+  if (!crash_file.empty()) {
+#if !defined(_WIN32)
+    return minimize_crash(crash_file, jobs, minimize_frames, artifact_path, max_len);
+#else
+    fprintf(stderr, "==minimize== needs fork(), which this platform doesn't have\n");
+    return 1;
+#endif
+  }
+
+  // Inputs: files from args (expanding directories and corpus packs), or
+  // stdin if none.
+  std::vector<Input> files;
+  std::vector<std::unique_ptr<CorpusPack>> packs;
+  bool inputs_ok = true;
+  const bool stress = stress_opts.threads > 0;
+  const bool minimize = !minimize_dir.empty();
+  const bool corpus = corpus_opts.stats || corpus_opts.dedup;
+  const bool stream = !bench && !stress && !minimize && !corpus && !keep_going && jobs <= 1 &&
+                      !sort_by_size;
+  InputQueue queue(kInputQueueDepth);
+  std::thread walker;
+  Input first;
+  bool have_inputs = false;
+  if (stream) {
+    walker = std::thread([&] {
+#if !defined(_WIN32)
+      // Leave the -timeout watchdog's SIGALRM to the replay thread.
+      sigset_t set;
+      sigemptyset(&set);
+      sigaddset(&set, SIGALRM);
+      pthread_sigmask(SIG_BLOCK, &set, nullptr);
+#endif
+      inputs_ok = collect_inputs(paths, max_files, packs,
+                                 [&](Input&& in) { return queue.push(std::move(in)); });
+      queue.finish();
+    });
+    have_inputs = queue.pop(first);
+    if (!have_inputs) walker.join();
+  } else {
+    inputs_ok = collect_inputs(paths, max_files, packs, [&](Input&& in) {
+      files.push_back(std::move(in));
+      return true;
+    });
+    have_inputs = !files.empty();
+  }
+  // (A streaming walk may still be running; its result is checked at the end.)
+  if ((!stream || !have_inputs) && !inputs_ok) return 1;
+  if (corpus && !have_inputs) {
+    fprintf(stderr, "==corpus== no inputs\n");
+    return 1;
+  }
+
+#if FUZZ_AFL_PERSISTENT
+  // No inputs under AFL++: this is a fuzzing run (or a single stdin input).
+  if (!have_inputs) {
+    run_afl_persistent(persistent_iters, max_len);
+    return 0;
+  }
+#else
+  (void)persistent_iters;
+#endif
+
+  InputLoader loader;
+  // No inputs? Read stdin once.
+  if (!have_inputs) {
+    if (!loader.load_fd(0, max_len)) return 1;
+    start_watchdog();
+    run_one(nullptr, loader.data(), loader.size());
+    report_memory();
+    return 0;
+  }
+
+  // The benchmark, stress, minimize and corpus modes always run everything.
+  ReplayCache replay_cache;
+  if (!replay_cache_dir.empty() && !bench && !stress && !minimize && !corpus) {
+    const std::string options = options_id(g_timeout_ns, g_rss_limit_mb, g_malloc_limit, max_len);
+    if (!replay_cache.open(replay_cache_dir, argv[0], options, force)) return 1;
+    g_replay_cache = &replay_cache;
+  }
+  auto report_cache = [&] {
+    if (!g_replay_cache) return;
+    fprintf(stderr, "==driver== replay cache %s: %llu inputs skipped, %llu new passes\n",
+            replay_cache.path().c_str(), static_cast<unsigned long long>(replay_cache.skipped),
+            static_cast<unsigned long long>(replay_cache.recorded));
+  };
+
+  // Serial replay overlapped with the walk.
+  if (stream) {
+    start_watchdog();
+    size_t limit = runs >= 0 ? static_cast<size_t>(runs) : SIZE_MAX;
+    for (size_t n = 0; n < limit; ++n) {
+      if (n > 0 && !queue.pop(first)) break;
+      run_input(loader, first, max_len);
+    }
+    queue.stop();
+    walker.join();
+    report_cache();
+    report_memory();
+    return inputs_ok ? 0 : 1;
+  }
+
+  if (sort_by_size) {
+    for (auto& in : files) {
+      struct stat st;
+      if (!in.data) in.size = stat(in.path.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    }
+    std::stable_sort(files.begin(), files.end(),
+                     [](const Input& a, const Input& b) { return a.size < b.size; });
+  }
+
+  size_t limit = runs >= 0 ? std::min(files.size(), static_cast<size_t>(runs)) : files.size();
+  if (bench) {
+    if (bench_opts.seconds <= 0 && bench_opts.iters == 0) bench_opts.seconds = 10;
+    start_watchdog();
+    return run_benchmark(files, limit, max_len, bench_opts);
+  }
+  if (stress) {
+    return run_stress(files, limit, max_len, stress_opts);
+  }
+  if (minimize) {
+    return minimize_corpus(files, limit, max_len, minimize_dir);
+  }
+  if (corpus) {
+    corpus_opts.threads = jobs;
+    corpus_opts.top = bench_opts.top;
+    return corpus_report(files, limit, max_len, corpus_opts);
+  }
+#if !defined(_WIN32)
+  if (keep_going || (jobs > 1 && limit > 1)) {
+    ForkOptions opts;
+    opts.jobs = static_cast<int>(std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(jobs), limit)));
+    opts.batch = keep_going ? batch : 0;
+    opts.verify = keep_going;
+    const int rc = run_files_forked(files, limit, max_len, opts);
+    report_cache();
+    return rc;
+  }
+#else
+  (void)jobs; (void)keep_going; (void)batch;
+#endif
+
+  start_watchdog();
+  for (size_t i = 0; i < limit; ++i) {
+    run_input(loader, files[i], max_len);
   }
+  report_cache();
+  report_memory();
 
   return 0;
 }
@@ -13,13 +13,52 @@ FUZZ_DIR="fuzz"
 
 TESTSUITE=${FUZZ_DIR}/testsuite
 RESULTS=${FUZZ_DIR}/results
+# Inputs known to pass per standalone binary; `test --force` re-runs them
+REPLAY_CACHE=${RESULTS}/replay-cache
+FORCE=0
+# --fast: build/run the campaign profile (-O2, no ASan; <harness>-<engine>-fast)
+FAST=0
+THINLTO=0
+# --pgo: train a profile on the corpus first and build the fast profile with it
+PGO=0
+PGO_PROFILE=""
+# Peak RSS (MB) at which a campaign input counts as an out-of-memory crash:
+# libFuzzer's -rss_limit_mb, enforced by the driver for AFL++ and honggfuzz
+RSS_LIMIT_MB=${RSS_LIMIT_MB:-2048}
 
 
 usage() {
   cat <<'USAGE'
 Usage:
-  ./fuzz.sh build [ENGINE]      # Build all engines (default) or just one
-  ./fuzz.sh test  [ENGINE] [S]  # Quick sanity fuzz; S seconds (default 10)
+  ./fuzz.sh build [ENGINE] [--fast [--thinlto] | --pgo [--thinlto]]
+                                # Build all engines (default) or just one.
+                                # --fast builds the campaign profile instead:
+                                # -O2, no ASan, UBSan in trap mode. --pgo
+                                # first replays the corpus through an
+                                # instrumented build and optimizes the fast
+                                # profile for it (-fprofile-use)
+  ./fuzz.sh test  [ENGINE] [S] [--force]
+                                # Quick sanity fuzz; S seconds (default 10).
+                                # Standalone replay skips inputs that already
+                                # passed on the same binary unless --force
+  ./fuzz.sh run   [S] [N] [--fast]
+                                # Campaign: every engine at once on N cores (default
+                                # all) for S seconds (default 3600) per harness.
+                                # --fast fuzzes with the fast builds and replays
+                                # their crashes and new corpus through ASan
+  ./fuzz.sh triage [HARNESS...] [-j N] [--frames N]
+                                # Replay campaign crashes through ASan on N jobs
+                                # and bucket them by bug type + top frames (3)
+  ./fuzz.sh coverage [HARNESS...] [-j N]
+                                # Replay each corpus through the source-based
+                                # coverage build on N workers and report what it
+                                # reaches (llvm-cov HTML + lcov, results/coverage)
+  ./fuzz.sh corpus stats|dedup [HARNESS...] [-j N]
+                                # Size histogram, duplicates, max_len suggestions
+                                # and slowest inputs of each testsuite + corpus;
+                                # dedup skips the timing and removes the exact
+                                # duplicates
+  ./fuzz.sh pack  [DIR] [OUT]   # Pack testsuites (or DIR) into one file each for replay
 
 Engines:
   libfuzzer   → Build with libFuzzer (requires clang++)
@@ -32,6 +71,12 @@ Examples:
   ./fuzz.sh build afl
   ./fuzz.sh test
   ./fuzz.sh test libfuzzer 5
+  ./fuzz.sh run 7200 32
+  ./fuzz.sh build --fast && ./fuzz.sh run 7200 32 --fast
+  ./fuzz.sh build --pgo && ./fuzz.sh run 7200 32 --fast
+  ./fuzz.sh coverage
+  ./fuzz.sh corpus dedup
+  ./fuzz.sh pack
 USAGE
 }
 
@@ -51,8 +96,14 @@ bindir_for() {
     afl)       echo "build/afl/bin" ;;
     honggfuzz)  echo "build/honggfuzz/bin" ;;
     standalone) echo "build/standalone/bin" ;;
+    libfuzzer-fast|afl-fast|honggfuzz-fast) echo "build/$1/bin" ;;
+    afl-cmplog|afl-laf|afl-cmplog-fast|afl-laf-fast) echo "build/$1/bin" ;;
+    coverage)  echo "build/coverage/bin" ;;
 {{else if (eq integration 'make')}}
     libfuzzer|afl|honggfuzz|standalone) echo "fuzz/build" ;;
+    libfuzzer-fast|afl-fast|honggfuzz-fast) echo "fuzz/build" ;;
+    afl-cmplog|afl-laf|afl-cmplog-fast|afl-laf-fast) echo "fuzz/build" ;;
+    coverage)  echo "fuzz/build" ;;
 {{/if}}
     *)         return 1 ;;
   esac
@@ -73,15 +124,52 @@ find_bins() {
 }
 
 
+# Build output of the dictionary extraction (fuzz/scripts/extract_dict.sh)
+generated_dicts() {
+{{#if (eq integration 'cmake')}}
+  ls build/*/dictionaries/"$1".dict 2>/dev/null || true
+{{else if (eq integration 'make')}}
+  ls fuzz/build/dictionaries/"$1".dict 2>/dev/null || true
+{{/if}}
+}
+
+# Dictionary the engines get for HARNESS: dictionaries/<harness>.dict merged
+# with the constants the build extracted, written to results/<harness>/fuzz.dict.
+# Prints its path, or nothing when there is neither.
+harness_dict() {
+  local harness="$1" out="${RESULTS}/$1/fuzz.dict" f
+  local srcs=()
+  [[ -f "${FUZZ_DIR}/dictionaries/${harness}.dict" ]] && srcs+=("${FUZZ_DIR}/dictionaries/${harness}.dict")
+  while IFS= read -r f; do [[ -n "$f" ]] && srcs+=("$f"); done < <(generated_dicts "$harness")
+  (( ${#srcs[@]} > 0 )) || return 0
+  mkdir -p "$(dirname "$out")"
+  awk '!/^[[:space:]]*(#|$)/ && !seen[$0]++' "${srcs[@]}" > "$out"
+  echo "$out"
+}
+
+# Harness name of an engine binary (<harness>-<engine>[-variant][-fast])
+harness_of() {
+  basename "$1" | sed -E 's/-(libfuzzer|afl|honggfuzz|native|standalone|coverage)(-[a-z]+)*$//'
+}
+
 # -------- Build --------
 
+# With --fast, ENGINE's fast profile is built instead (fuzz-ENGINE-fast)
 build_engine() {
   local engine="$1"
   local log="${RESULTS}/${engine}-build.log"
 {{#if (eq integration 'cmake')}}
   local preset="fuzz-$engine"
-  printf "%-60s" "+ cmake --preset $preset"
-  if cmake --preset "$preset" > $log 2>&1; then
+  local extra=()
+  if [[ "$FAST" == 1 ]]; then
+    preset="fuzz-$engine-fast"
+    log="${RESULTS}/${engine}-fast-build.log"
+    [[ "$THINLTO" == 1 ]] && extra=(-DFUZZ_THINLTO=ON)
+    # Always set, so a plain --fast build drops an earlier --pgo profile
+    extra+=(-DFUZZ_PGO_PROFILE="$PGO_PROFILE")
+  fi
+  printf "%-60s" "+ cmake --preset $preset ${extra[*]+${extra[*]}}"
+  if cmake --preset "$preset" ${extra[@]+"${extra[@]}"} > $log 2>&1; then
       echo "[OK]"
       printf "%-60s" "+ cmake --build --preset $preset"
       if cmake --build --preset "$preset" >> $log 2>&1; then
@@ -98,8 +186,15 @@ build_engine() {
       echo "- Note: see `realpath $log` for details"
   fi
 {{else if (eq integration 'make')}}
-  printf "%-60s" "+ make fuzz-$engine"
-  if make "fuzz-$engine" > $log 2>&1; then
+  local extra=()
+  if [[ "$FAST" == 1 ]]; then
+    log="${RESULTS}/${engine}-fast-build.log"
+    extra=(FUZZ_PROFILE=fast)
+    [[ "$THINLTO" == 1 ]] && extra+=(THINLTO=1)
+    [[ -n "$PGO_PROFILE" ]] && extra+=(PGO_PROFILE="$PGO_PROFILE")
+  fi
+  printf "%-60s" "+ make fuzz-$engine ${extra[*]+${extra[*]}}"
+  if make "fuzz-$engine" ${extra[@]+"${extra[@]}"} > $log 2>&1; then
       echo "[OK]"
   else
       echo "[FAIL]"
@@ -110,12 +205,61 @@ build_engine() {
 {{/if}}
 }
 
+# AFL++ and the companions `run` adds to its instances: the CmpLog binary
+# (afl-fuzz -c) and a LAF-intel split-compares build for one secondary
+build_afl() {
+  build_engine afl
+  build_engine afl-cmplog
+  build_engine afl-laf
+}
+
+{{#if (eq integration 'cmake')}}
+# Every engine tree (the AFL++ companions included) through the fuzz-all
+# superbuild preset: configured and built at the same time on one pool of
+# $(nproc) jobs, into the same build/<engine> trees build_engine uses
+build_all() {
+  local preset="fuzz-all"
+  local log="${RESULTS}/all-build.log"
+  local extra=()
+  if [[ "$FAST" == 1 ]]; then
+    preset="fuzz-all-fast"
+    log="${RESULTS}/all-fast-build.log"
+    [[ "$THINLTO" == 1 ]] && extra=(-DFUZZ_THINLTO=ON)
+    if [[ "$PGO" == 1 ]]; then
+      preset="fuzz-all-pgo"
+      log="${RESULTS}/all-pgo-build.log"
+    fi
+    extra+=(-DFUZZ_PGO_PROFILE="$PGO_PROFILE")
+  fi
+  printf "%-60s" "+ cmake --preset $preset ${extra[*]+${extra[*]}}"
+  if ! cmake --preset "$preset" ${extra[@]+"${extra[@]}"} > $log 2>&1; then
+      echo "[FAIL]"
+      cat $log
+      echo "Failed to configure the superbuild, the above log is stored at"
+      echo $(realpath $log)
+      return
+  fi
+  echo "[OK]"
+  sed -n 's/^-- Skipping \([^:]*\): \(.*\)$/- Note: \1 skipped (\2)/p' $log
+  printf "%-60s" "+ cmake --build --preset $preset -j $(nproc)"
+  if cmake --build --preset "$preset" --parallel "$(nproc)" >> $log 2>&1; then
+      echo "[OK]"
+  else
+      echo "[FAIL]"
+      cat $log
+      echo "Failed to build fuzzer, the above log is stored at"
+      echo $(realpath $log)
+  fi
+}
+{{else}}
 build_all() {
   build_engine libfuzzer
-  build_engine afl
+  build_afl
   build_engine honggfuzz
-  build_engine standalone
+  # The standalone build has no sanitizers, so it has no fast profile
+  [[ "$FAST" == 1 ]] || build_engine standalone
 }
+{{/if}}
 
 # -------- Test (quick sanity) --------
 
@@ -127,8 +271,11 @@ test_libfuzzer() {
     local output="${RESULTS}/$name"
     mkdir -p "$output"
     cp -r "$TESTSUITE"/* "$output"
+    local dict dict_args=()
+    dict="$(harness_dict "$(harness_of "$bin")")"
+    [[ -n "$dict" ]] && dict_args=(-dict="$dict")
     echo "+ [libfuzzer] $name for ${secs}s"
-    "$bin" -max_total_time="$secs" -print_final_stats=1 "$output" || true
+    "$bin" -max_total_time="$secs" -print_final_stats=1 ${dict_args[@]+"${dict_args[@]}"} "$output" || true
   done < <(find_bins libfuzzer)
 }
 
@@ -143,8 +290,13 @@ test_afl() {
     local name="$(basename "$bin")"
     local work="$RESULTS/$name"
     mkdir -p "$work"
+    local dict dict_args=()
+    dict="$(harness_dict "$(harness_of "$bin")")"
+    [[ -n "$dict" ]] && dict_args=(-x "$dict")
     echo "+ [AFL++] $name for ${secs}s"
-    afl-fuzz -m none -V "$secs" -i "$TESTSUITE" -o "$work" -- "$bin" @@ || true
+    # No @@: the driver runs in persistent mode and takes testcases from
+    # shared memory, so afl-fuzz must not route them through a file.
+    afl-fuzz -m none -V "$secs" ${dict_args[@]+"${dict_args[@]}"} -i "$TESTSUITE" -o "$work" -- "$bin" || true
   done < <(find_bins afl)
 }
 
@@ -159,20 +311,31 @@ test_honggfuzz() {
     local name="$(basename "$bin")"
     local work="$RESULTS/$name"
     mkdir -p "$work"
+    local dict dict_args=()
+    dict="$(harness_dict "$(harness_of "$bin")")"
+    [[ -n "$dict" ]] && dict_args=(--dict "$dict")
     echo "+ [honggfuzz] $name for ${secs}s"
-    timeout -k 1 $secs honggfuzz -i "$TESTSUITE" -o "$work" -- "$bin" ___FILE___ || true
+    timeout -k 1 $secs honggfuzz -i "$TESTSUITE" -o "$work" ${dict_args[@]+"${dict_args[@]}"} -- "$bin" ___FILE___ || true
   done < <(find_bins honggfuzz)
 }
 
+# Standalone replay binaries: <harness>-native (CMake) or <harness>-standalone
+# (make). The bin dir can also hold test_<project> and bench_lib.
+standalone_bins() {
+  find_bins standalone | grep -E -e '-(native|standalone)$' | LC_ALL=C sort || true
+}
+
 test_standalone() {
   local secs="${1:-10}"
   while IFS= read -r bin; do
     [[ -z "$bin" ]] && continue
     local name="$(basename "$bin")"
+    local cache_args=(-replay_cache="$REPLAY_CACHE")
+    [[ "$FORCE" == 1 ]] && cache_args+=(--force)
     echo "+ [standalone] $name using testsuite (timeout ${secs}s each)"
-    echo timeout -k 1 $secs "./$bin" "$TESTSUITE"
-    timeout -k 1 $secs "./$bin" "$TESTSUITE"
-  done < <(find_bins standalone)
+    echo timeout -k 1 $secs "./$bin" "${cache_args[@]}" "$TESTSUITE"
+    timeout -k 1 $secs "./$bin" "${cache_args[@]}" "$TESTSUITE"
+  done < <(standalone_bins)
 }
 
 test_all() {
@@ -184,6 +347,815 @@ test_all() {
   echo "Quick tests complete."
 }
 
+# -------- Campaign (parallel, all engines) --------
+
+# Binary of ENGINE for HARNESS, if built. CMake names standalone targets
+# <harness>-native, make names them <harness>-standalone.
+bin_for() {
+  local engine="$1" harness="$2" suffix="$1"
+  [[ "$engine" == "standalone" ]] && suffix="native|standalone"
+  find_bins "$engine" | grep -E "/${harness}-(${suffix})\$" | head -n 1 || true
+}
+
+# Engine name of the profile being fuzzed: ENGINE, or ENGINE-fast with --fast
+campaign_engine() {
+  if [[ "$FAST" == 1 ]]; then echo "$1-fast"; else echo "$1"; fi
+}
+
+# Harnesses with at least one fuzzing-engine binary
+campaign_harnesses() {
+  local engine
+  for engine in libfuzzer afl honggfuzz; do
+    engine="$(campaign_engine "$engine")"
+    find_bins "$engine" | grep -E -- "-${engine}\$" || true
+  done | while IFS= read -r bin; do basename "$bin"; done \
+       | sed -E 's/-(libfuzzer|afl|honggfuzz)(-fast)?$//' | LC_ALL=C sort -u
+}
+
+# asan_replay HARNESS WHAT FILE...: replay what a fast campaign found through
+# the sanitizer (triage) build so that it's confirmed and symbolized. The AFL++
+# build replays through the driver in forked batches; the libFuzzer build
+# runs one input per process. (Honggfuzz's CMake build has no ASan.)
+asan_replay() {
+  local harness="$1" what="$2"; shift 2
+  (( $# > 0 )) || return 0
+  local log="${RESULTS}/${harness}/logs/asan-${what// /-}.log"
+  local bin
+  bin="$(bin_for afl "$harness")"
+  if [[ -n "$bin" ]]; then
+    echo "+ [$harness] replaying $# ${what} through $(basename "$bin"); log in ${log}"
+    "$bin" -keep_going=1 -batch=1 -rss_limit_mb="$RSS_LIMIT_MB" "$@" 2>&1 | tee "$log" | grep -E '^==driver==' || true
+    return 0
+  fi
+  bin="$(bin_for libfuzzer "$harness")"
+  if [[ -z "$bin" ]]; then
+    echo "!! [$harness] no ASan build to confirm ${what}; run ./fuzz.sh build afl (or libfuzzer)"
+    return 0
+  fi
+  echo "+ [$harness] replaying $# ${what} through $(basename "$bin"); log in ${log}"
+  : > "$log"
+  local f crashed=0
+  for f in "$@"; do
+    echo "=== $f" >> "$log"
+    if ! "$bin" "$f" >> "$log" 2>&1; then
+      crashed=$((crashed + 1))
+      echo "  crashed: $f"
+    fi
+  done
+  echo "+ [$harness] ${crashed} of $# ${what} crash under ASan"
+}
+
+# start_pinned LOG FIRST COUNT CMD...: start CMD in the background, logging
+# to LOG, on cores FIRST..FIRST+COUNT-1 when taskset is available and those
+# cores exist. $! is CMD's pid afterwards (taskset execs it).
+start_pinned() {
+  local log="$1" first="$2" count="$3"; shift 3
+  if command -v taskset >/dev/null 2>&1 && (( first + count <= $(nproc) )); then
+    taskset -c "${first}-$((first + count - 1))" "$@" > "$log" 2>&1 &
+  else
+    "$@" > "$log" 2>&1 &
+  fi
+}
+
+# -------- Telemetry --------
+
+# Seconds between samples while a campaign runs
+TELEMETRY_INTERVAL=${TELEMETRY_INTERVAL:-10}
+
+# Each sampler prints "execs_per_sec,coverage,corpus,crashes"; fields an
+# engine doesn't report stay empty. Coverage is in the engine's own unit
+# (AFL++ edges_found, libFuzzer cov, honggfuzz edges).
+
+# AFL++ instance directory (with fuzzer_stats)
+afl_sample() {
+  local stats="$1/fuzzer_stats"
+  if [[ ! -f "$stats" ]]; then echo ",,,"; return; fi
+  awk -F' *: *' '{ v[$1] = $2 }
+    END {
+      crashes = ("saved_crashes" in v) ? v["saved_crashes"] : v["unique_crashes"]
+      printf "%s,%s,%s,%s\n", v["execs_per_sec"], v["edges_found"], v["corpus_count"], crashes
+    }' "$stats"
+}
+
+# libFuzzer log: the last "#N ... cov: ... corp: ... exec/s: ..." status line
+# (-fork mode prints "exec/s N" and "oom/timeout/crash: a/b/c" instead)
+libfuzzer_sample() {
+  local log="$1" crashes_dir="$2" line
+  line="$(grep -E '^#[0-9]+' "$log" 2>/dev/null | tail -n 1 || true)"
+  local eps cov corp crashes
+  eps="$(sed -nE 's/.* exec\/s:? ([0-9]+).*/\1/p' <<<"$line")"
+  cov="$(sed -nE 's/.* cov: ([0-9]+).*/\1/p' <<<"$line")"
+  corp="$(sed -nE 's/.* corp: ([0-9]+).*/\1/p' <<<"$line")"
+  crashes="$(sed -nE 's/.*oom\/timeout\/crash: [0-9]+\/[0-9]+\/([0-9]+).*/\1/p' <<<"$line")"
+  if [[ -z "$crashes" ]]; then
+    crashes="$(find "$crashes_dir" -name 'crash-*' 2>/dev/null | wc -l | tr -d ' ')"
+  fi
+  echo "${eps},${cov},${corp},${crashes}"
+}
+
+# honggfuzz log: "speed:" and the edge total of the last "Cur:" coverage line,
+# plus the files in the shared corpus and its SIG* crash files
+honggfuzz_sample() {
+  local log="$1" corpus="$2" crashes_dir="$3"
+  local eps cov corp crashes
+  eps="$(grep -oE 'speed: ?[0-9]+' "$log" 2>/dev/null | tail -n 1 | grep -oE '[0-9]+' || true)"
+  cov="$(grep -oE 'Cur: ?[0-9]+/[0-9]+/[0-9]+/[0-9]+' "$log" 2>/dev/null | tail -n 1 \
+         | sed -E 's#.*/##' || true)"
+  corp="$(find "$corpus" -type f 2>/dev/null | wc -l | tr -d ' ')"
+  crashes="$(find "$crashes_dir" -name 'SIG*' 2>/dev/null | wc -l | tr -d ' ')"
+  echo "${eps},${cov},${corp},${crashes}"
+}
+
+# Resident memory in MiB of PID and all of its descendants (forkservers,
+# libFuzzer -fork jobs, ...)
+rss_mb() {
+  ps -eo pid=,ppid=,rss= 2>/dev/null | awk -v root="$1" '
+    { rss[$1] = $3; kids[$2] = kids[$2] " " $1 }
+    END {
+      n = 1; stack[1] = root; total = 0
+      while (n > 0) {
+        p = stack[n--]; total += rss[p]
+        m = split(kids[p], k, " ")
+        for (i = 1; i <= m; i++) stack[++n] = k[i]
+      }
+      printf "%.1f", total / 1024
+    }'
+}
+
+# collect_telemetry OUT WORK HARNESS SPEC...: append one CSV row per running
+# instance to OUT every TELEMETRY_INTERVAL seconds until none is left. Each
+# SPEC is "engine|instance|pid|source", source being the AFL++ instance
+# directory or the engine's log.
+collect_telemetry() {
+  local out="$1" work="$2" harness="$3"; shift 3
+  local start=$SECONDS
+  if [[ ! -s "$out" ]]; then
+    echo "time,elapsed_s,harness,engine,instance,execs_per_sec,coverage,corpus,crashes,rss_mb" > "$out"
+  fi
+  while :; do
+    sleep "$TELEMETRY_INTERVAL"
+    local now spec engine inst pid src vals alive=0
+    now="$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+    for spec in "$@"; do
+      IFS='|' read -r engine inst pid src <<<"$spec"
+      kill -0 "$pid" 2>/dev/null || continue
+      alive=1
+      case "$engine" in
+        afl)       vals="$(afl_sample "$src")" ;;
+        libfuzzer) vals="$(libfuzzer_sample "$src" "${work}/crashes")" ;;
+        honggfuzz) vals="$(honggfuzz_sample "$src" "${work}/corpus" "${work}/crashes")" ;;
+      esac
+      echo "${now},$((SECONDS - start)),${harness},${engine},${inst},${vals},$(rss_mb "$pid")" >> "$out"
+    done
+    (( alive )) || break
+  done
+}
+
+# Fuzzes one harness with every available engine side by side. All engines
+# share results/<harness>/corpus: libFuzzer and honggfuzz add to it directly
+# and AFL++'s main instance imports it with -F, while its secondaries sync
+# through results/<harness>/afl. Each engine gets its own range of cores.
+run_campaign_harness() {
+  local harness="$1" secs="$2" ncores="$3"
+  local work="${RESULTS}/${harness}"
+  local corpus="${work}/corpus" crashes="${work}/crashes" logs="${work}/logs"
+  mkdir -p "$corpus" "$crashes" "$logs"
+  local dict
+  dict="$(harness_dict "$harness")"
+  if [[ -d "${TESTSUITE}/${harness}" ]]; then
+    cp -rn "${TESTSUITE}/${harness}"/. "$corpus"/ 2>/dev/null || true
+  fi
+  # afl-fuzz refuses an empty input directory
+  [[ -n "$(ls -A "$corpus")" ]] || printf 'A' > "${corpus}/seed"
+
+  local lf_bin afl_bin hf_bin cmplog_bin laf_bin
+  lf_bin="$(bin_for "$(campaign_engine libfuzzer)" "$harness")"
+  afl_bin="$(bin_for "$(campaign_engine afl)" "$harness")"
+  cmplog_bin="$(bin_for "$(campaign_engine afl-cmplog)" "$harness")"
+  laf_bin="$(bin_for "$(campaign_engine afl-laf)" "$harness")"
+  hf_bin="$(bin_for "$(campaign_engine honggfuzz)" "$harness")"
+  command -v afl-fuzz >/dev/null 2>&1 || afl_bin=""
+  command -v honggfuzz >/dev/null 2>&1 || hf_bin=""
+
+  local engines=()
+  [[ -n "$afl_bin" ]] && engines+=(afl)
+  [[ -n "$lf_bin" ]] && engines+=(libfuzzer)
+  [[ -n "$hf_bin" ]] && engines+=(honggfuzz)
+  if (( ${#engines[@]} == 0 )); then
+    echo "!! [$harness] no fuzzing engine binaries (or afl-fuzz/honggfuzz) found; run ./fuzz.sh build"
+    return 0
+  fi
+
+  # Split the cores evenly; AFL++ gets any remainder.
+  local per=$(( ncores / ${#engines[@]} ))
+  (( per > 0 )) || per=1
+  local afl_n=0 lf_n=0 hf_n=0
+  [[ -n "$lf_bin" ]] && lf_n=$per
+  [[ -n "$hf_bin" ]] && hf_n=$per
+  if [[ -n "$afl_bin" ]]; then
+    afl_n=$(( ncores - lf_n - hf_n ))
+    (( afl_n > 0 )) || afl_n=1
+  fi
+
+  # Everything newer than this was found by this campaign
+  local stamp="${work}/.campaign-start"
+  touch "$stamp"
+  local pids=() specs=()
+  trap 'kill "${pids[@]}" 2>/dev/null || true' INT TERM
+  local core=0 i
+  if [[ -n "$afl_bin" ]]; then
+    local dict_args=()
+    [[ -n "$dict" ]] && dict_args=(-x "$dict")
+    echo "+ [$harness] AFL++: $afl_n instance(s) on cores ${core}-$((core + afl_n - 1))"
+    [[ -n "$cmplog_bin" ]] && echo "+ [$harness] AFL++: main uses CmpLog ($(basename "$cmplog_bin"))"
+    [[ -n "$laf_bin" ]] && (( afl_n > 1 )) && echo "+ [$harness] AFL++: s1 runs $(basename "$laf_bin")"
+    for (( i = 0; i < afl_n; i++ )); do
+      # The main instance solves magic values with CmpLog, s1 fuzzes the
+      # split-compares build so multi-byte comparisons give partial progress.
+      local role=(-S "s$i") target="$afl_bin" extra=()
+      if (( i == 0 )); then
+        role=(-M main -F "$corpus")
+        [[ -n "$cmplog_bin" ]] && extra=(-c "$cmplog_bin")
+      elif (( i == 1 )) && [[ -n "$laf_bin" ]]; then
+        target="$laf_bin"
+      fi
+      local bind=()
+      (( core + i < $(nproc) )) && bind=(-b "$((core + i))")
+      AFL_NO_UI=1 AFL_AUTORESUME=1 afl-fuzz "${role[@]}" ${bind[@]+"${bind[@]}"} -m none -V "$secs" \
+        ${extra[@]+"${extra[@]}"} ${dict_args[@]+"${dict_args[@]}"} -i "$corpus" -o "${work}/afl" \
+        -- "$target" -rss_limit_mb="$RSS_LIMIT_MB" > "${logs}/afl-$i.log" 2>&1 &
+      pids+=($!)
+      specs+=("afl|${role[1]}|$!|${work}/afl/${role[1]}")
+    done
+    core=$(( core + afl_n ))
+  fi
+  if [[ -n "$lf_bin" ]]; then
+    local dict_args=()
+    [[ -n "$dict" ]] && dict_args=(-dict="$dict")
+    echo "+ [$harness] libFuzzer: -fork=$lf_n on cores ${core}-$((core + lf_n - 1))"
+    start_pinned "${logs}/libfuzzer.log" "$core" "$lf_n" \
+      "$lf_bin" -fork="$lf_n" -ignore_crashes=1 -max_total_time="$secs" -rss_limit_mb="$RSS_LIMIT_MB" \
+      -artifact_prefix="${crashes}/" ${dict_args[@]+"${dict_args[@]}"} "$corpus"
+    pids+=($!)
+    specs+=("libfuzzer|fork|$!|${logs}/libfuzzer.log")
+    core=$(( core + lf_n ))
+  fi
+  if [[ -n "$hf_bin" ]]; then
+    local dict_args=()
+    [[ -n "$dict" ]] && dict_args=(--dict "$dict")
+    echo "+ [$harness] honggfuzz: -n $hf_n on cores ${core}-$((core + hf_n - 1))"
+    start_pinned "${logs}/honggfuzz.log" "$core" "$hf_n" \
+      honggfuzz -n "$hf_n" --run_time "$secs" -i "$corpus" \
+      --crashdir "$crashes" ${dict_args[@]+"${dict_args[@]}"} -- "$hf_bin" -rss_limit_mb="$RSS_LIMIT_MB" ___FILE___
+    pids+=($!)
+    specs+=("honggfuzz|main|$!|${logs}/honggfuzz.log")
+  fi
+
+  collect_telemetry "${work}/telemetry.csv" "$work" "$harness" "${specs[@]}" &
+  local collector=$!
+  echo "+ [$harness] fuzzing for ${secs}s; logs in ${logs}, telemetry in ${work}/telemetry.csv"
+  wait "${pids[@]}" || true
+  kill "$collector" 2>/dev/null || true
+  wait "$collector" 2>/dev/null || true
+  trap - INT TERM
+
+  # Replay everything that crashed, one forked child per input, with the
+  # standalone build so crashes are listed with their signals.
+  local found=()
+  while IFS= read -r f; do found+=("$f"); done < <(
+    find "$crashes" "${work}/afl" -type f -path '*/crashes/*' ! -name 'README.txt' 2>/dev/null \
+      | LC_ALL=C sort)
+  echo "+ [$harness] corpus: $(find "$corpus" -type f | wc -l) inputs, crashes: ${#found[@]}"
+  if [[ "$FAST" == 1 ]]; then
+    local fresh=()
+    while IFS= read -r f; do fresh+=("$f"); done < <(
+      find "$corpus" "${work}/afl" -type f -newer "$stamp" \
+        \( -path "${corpus}/*" -o -path '*/queue/*' \) ! -path '*/.state/*' 2>/dev/null \
+        | LC_ALL=C sort)
+    asan_replay "$harness" crashes ${found[@]+"${found[@]}"}
+    asan_replay "$harness" "new inputs" ${fresh[@]+"${fresh[@]}"}
+    return 0
+  fi
+  local sa_bin
+  sa_bin="$(bin_for standalone "$harness")"
+  if (( ${#found[@]} > 0 )) && [[ -n "$sa_bin" ]]; then
+    "$sa_bin" -keep_going=1 -batch=1 -rss_limit_mb="$RSS_LIMIT_MB" "${found[@]}" || true
+  fi
+}
+
+run_campaign() {
+  local secs="${1:-3600}" ncores="${2:-$(nproc)}"
+  local harnesses=() h
+  while IFS= read -r h; do [[ -n "$h" ]] && harnesses+=("$h"); done < <(campaign_harnesses)
+  if (( ${#harnesses[@]} == 0 )); then
+    echo "!! no fuzz targets found; run ./fuzz.sh build first"
+    return 1
+  fi
+  for h in "${harnesses[@]}"; do
+    run_campaign_harness "$h" "$secs" "$ncores"
+  done
+}
+
+# -------- Triage --------
+
+# Seconds one crash may run before triage records it as a timeout
+TRIAGE_TIMEOUT=${TRIAGE_TIMEOUT:-10}
+
+# Symbolizer for raw frames; one process per module, fed every frame at once
+addr2line_tool() {
+  command -v llvm-addr2line 2>/dev/null || command -v addr2line 2>/dev/null || true
+}
+
+# Crash files a campaign left for HARNESS (libFuzzer artifacts and honggfuzz
+# in results/<harness>/crashes, AFL++ in each instance's crashes/)
+triage_inputs() {
+  local work="${RESULTS}/$1"
+  find "${work}/crashes" "${work}/afl" -type f \
+    \( -path "${work}/crashes/*" -o -path '*/crashes/*' \) \
+    ! -name README.txt ! -name 'HONGGFUZZ.REPORT.TXT' ! -name '.*' 2>/dev/null \
+    | LC_ALL=C sort
+}
+
+# triage_each BIN OUT JOBS TIMEOUT_FLAG < LIST: runs BIN on each input in
+# LIST in its own process, JOBS at a time, capturing stderr as the report.
+# Prints "input<TAB>report<TAB>exit code N" for each one that failed.
+triage_each() {
+  local bin="$1" out="$2" jobs="$3" timeout_flag="$4" f n=0
+  mkdir -p "${out}/reports"
+  while IFS= read -r f; do
+    printf '%s\t%s\n' "$f" "${out}/reports/${n}.txt"
+    n=$((n + 1))
+  done > "${out}/each.tsv"
+  tr '\t' '\n' < "${out}/each.tsv" | tr '\n' '\0' \
+    | xargs -0 -n 2 -P "$jobs" sh -c \
+        '"$0" "$1" -rss_limit_mb="$2" "$3" > "$4" 2>&1; echo $? > "$4.rc"' \
+        "$bin" "$timeout_flag" "$RSS_LIMIT_MB" 2>/dev/null || true
+  local report rc
+  while IFS=$'\t' read -r f report; do
+    rc="$(cat "${report}.rc" 2>/dev/null || echo 0)"
+    [[ "$rc" == 0 ]] || printf '%s\t%s\texit code %s\n' "$f" "$report" "$rc"
+  done < "${out}/each.tsv"
+}
+
+# Writes OUT/index.tsv (input, report file or "-", status) for every input that
+# crashes BIN. Driver builds replay in -jobs=N forked workers, each
+# sanitizer report going to its own file through
+# AFL_DRIVER_STDERR_DUPLICATE_FILENAME; libFuzzer builds run one process per
+# input, N at a time.
+triage_replay() {
+  local bin="$1" out="$2" jobs="$3"; shift 3
+  mkdir -p "${out}/reports"
+  # Raw frames only; triage_bucket symbolizes each distinct one afterwards
+  local -x ASAN_OPTIONS="${ASAN_OPTIONS:+${ASAN_OPTIONS}:}symbolize=0:handle_abort=1"
+  local -x UBSAN_OPTIONS="${UBSAN_OPTIONS:+${UBSAN_OPTIONS}:}symbolize=0:print_stacktrace=1"
+  if [[ "$bin" == *-libfuzzer ]]; then
+    printf '%s\n' "$@" | triage_each "$bin" "$out" "$jobs" -timeout="$TRIAGE_TIMEOUT" > "${out}/index.tsv"
+    return 0
+  fi
+  (( jobs > 1 )) || jobs=2  # -jobs=1 would replay in-process
+  AFL_DRIVER_STDERR_DUPLICATE_FILENAME="${out}/reports/report" \
+    "$bin" -jobs="$jobs" -timeout=$(( TRIAGE_TIMEOUT * 1000 )) -rss_limit_mb="$RSS_LIMIT_MB" \
+    "$@" > "${out}/replay.log" 2>&1 || true
+  # "==driver==   PATH: STATUS[, report FILE]" per crash
+  awk '/^==driver==   / {
+    line = substr($0, 14); i = index(line, ": ")
+    path = substr(line, 1, i - 1); status = substr(line, i + 2); report = "-"
+    if ((j = index(status, ", report ")) > 0) { report = substr(status, j + 9); status = substr(status, 1, j - 1) }
+    print path "\t" report "\t" status
+  }' "${out}/replay.log" > "${out}/index.tsv"
+  # Reports that didn't follow the report path (gcc's separate UBSan runtime
+  # writes to stderr) come from re-running those inputs on their own
+  local -A alone=()
+  local f report status
+  while IFS=$'\t' read -r f report status; do alone["$f"]="$report"; done < <(
+    awk -F'\t' '$2 == "-" && $3 !~ /^timeout/ { print $1 }' "${out}/index.tsv" \
+      | triage_each "$bin" "${out}/alone" "$jobs" -timeout=$(( TRIAGE_TIMEOUT * 1000 )))
+  (( ${#alone[@]} > 0 )) || return 0
+  while IFS=$'\t' read -r f report status; do
+    [[ "$report" == "-" && -n "${alone[$f]:-}" ]] && report="${alone[$f]}"
+    printf '%s\t%s\t%s\n' "$f" "$report" "$status"
+  done < "${out}/index.tsv" > "${out}/index.tsv.new"
+  mv "${out}/index.tsv.new" "${out}/index.tsv"
+}
+
+# Buckets the crashes in OUT/index.tsv by sanitizer bug type and the top
+# FRAMES frames of the crashing stack, outside the sanitizer runtime, libc
+# and the driver. Each distinct frame is symbolized once. Writes
+# OUT/buckets/<hash>/{input,report.txt,inputs.txt} with the smallest input of
+# each bucket as its representative, and OUT/summary.txt.
+triage_bucket() {
+  local out="$1" frames="$2"
+  # 1. Bug type and raw frames of the first stack after the error line
+  awk -F'\t' -v OFS='\t' '
+    {
+      n++; input[n] = $1; type = ""; instack = 0; k = 0
+      if ($2 != "-") {
+        while ((getline line < $2) > 0) {
+          if (type == "") {
+            if (match(line, /ERROR: [A-Za-z]+: /)) {
+              t = substr(line, RSTART + 7, RLENGTH - 7); rest = substr(line, RSTART + RLENGTH)
+              split(rest, w, " ")
+              type = (t ~ /^LeakSanitizer/) ? "memory-leak" : w[1]
+            } else if (match(line, /runtime error: /)) {
+              # "index 9 out of bounds for type ..." -> "index out of bounds"
+              type = substr(line, RSTART + RLENGTH); sub(/:.*/, "", type)
+              gsub(/ [^ ]*[0-9][^ ]*/, "", type); sub(/,? (for|of) type .*/, "", type); sub(/,.*/, "", type)
+            }
+            continue
+          }
+          if (line ~ /^ *#[0-9]+ /) {
+            instack = 1
+            sub(/ \(BuildId: [0-9a-f]+\)$/, "", line)
+            if (!match(line, /\(.*\+0x[0-9a-f]+\)$/)) continue
+            modoff = substr(line, RSTART + 1, RLENGTH - 2)
+            p = match(modoff, /\+0x[0-9a-f]+$/)
+            print n, k++, substr(modoff, 1, p - 1), substr(modoff, p + 1) > "'"${out}"'/frames.tsv"
+          } else if (instack) break
+        }
+        close($2)
+      }
+      if (type == "") type = $3
+      print n, type, $1 > "'"${out}"'/types.tsv"
+    }' "${out}/index.tsv"
+  touch "${out}/frames.tsv" "${out}/types.tsv"
+
+  # 2. Symbolize every distinct frame of the binaries (not the runtime
+  #    libraries) with one addr2line per module
+  local a2l module
+  local runtime='/(lib(asan|ubsan|tsan|msan|lsan|clang_rt|c|m|stdc[+][+]|gcc_s|pthread)[.-][^/]*|ld-[^/]*)$'
+  a2l="$(addr2line_tool)"
+  : > "${out}/symbols.tsv"
+  awk -F'\t' -v rt="$runtime" '$3 !~ rt { print $3 "\t" $4 }' \
+    "${out}/frames.tsv" | LC_ALL=C sort -u > "${out}/addrs.tsv"
+  if [[ -n "$a2l" ]]; then
+    while IFS= read -r module; do
+      awk -F'\t' -v m="$module" '$1 == m { print $2 }' "${out}/addrs.tsv" > "${out}/offsets"
+      # Return addresses point after the call; look up the call itself
+      awk '{
+        h = tolower(substr($0, 3)); v = 0
+        for (i = 1; i <= length(h); i++) v = v * 16 + index("0123456789abcdef", substr(h, i, 1)) - 1
+        printf "0x%x\n", (v > 0 ? v - 1 : 0)
+      }' "${out}/offsets" \
+        | "$a2l" -f -C -e "$module" 2>/dev/null \
+        | paste - - | paste "${out}/offsets" - \
+        | awk -F'\t' -v m="$module" -v OFS='\t' '{ print m, $1, $2, $3 }' >> "${out}/symbols.tsv"
+    done < <(cut -f1 "${out}/addrs.tsv" | LC_ALL=C sort -u)
+  fi
+
+  # 3. Bucket key: type + the top FRAMES interesting function names
+  awk -F'\t' -v OFS='\t' -v N="$frames" -v rt="$runtime" '
+    BEGIN { for (i = 1; i < 256; i++) ord[sprintf("%c", i)] = i }
+    function hash(s,    h, i) {
+      h = 5381
+      for (i = 1; i <= length(s); i++) h = (h * 131 + ord[substr(s, i, 1)]) % 4294967291
+      return sprintf("%08x", h)
+    }
+    FILENAME ~ /symbols.tsv$/ { fn[$1 "\t" $2] = $3; loc[$1 "\t" $2] = $4; next }
+    FILENAME ~ /frames.tsv$/ {
+      if ($3 ~ rt) next
+      key = $3 "\t" $4
+      f = (key in fn) ? fn[key] : "??"
+      if (f ~ /^_*(asan|sanitizer|interceptor|ubsan|lsan|msan|tsan)_/ || loc[key] ~ /driver\/main\.cpp:/) next
+      if (f == "??") { m = $3; sub(/.*\//, "", m); f = m "+" $4 }
+      if (++taken[$1] <= N) top[$1] = (top[$1] == "" ? "" : top[$1] " < ") f
+      next
+    }
+    {
+      desc = (top[$1] == "" ? "(no stack)" : top[$1])
+      print hash($2 "|" desc), $2, desc, $3
+    }' "${out}/symbols.tsv" "${out}/frames.tsv" "${out}/types.tsv" > "${out}/assign.tsv"
+
+  # 4. One directory per bucket, represented by its smallest input
+  cut -f4 "${out}/assign.tsv" | tr '\n' '\0' | xargs -0 wc -c 2>/dev/null \
+    | awk '$2 != "total" || NF > 2 { s = $1; sub(/^ *[0-9]+ /, ""); print $0 "\t" s }' > "${out}/sizes.tsv"
+  awk -F'\t' -v OFS='\t' '
+    FILENAME ~ /sizes.tsv$/ { size[$1] = $2; next }
+    {
+      count[$1]++; type[$1] = $2; desc[$1] = $3
+      s = ($4 in size) ? size[$4] + 0 : 0
+      if (!($1 in rep) || s < best[$1]) { rep[$1] = $4; best[$1] = s }
+    }
+    END { for (b in count) print count[b], b, type[b], rep[b], desc[b] }' \
+    "${out}/sizes.tsv" "${out}/assign.tsv" | LC_ALL=C sort -t$'\t' -k1,1nr -k2,2 > "${out}/buckets.tsv"
+
+  local count id type rep desc report
+  rm -rf "${out}/buckets"
+  {
+    printf '%-8s  %6s  %-24s  %s\n' bucket count type "top frames / representative"
+    while IFS=$'\t' read -r count id type rep desc; do
+      local dir="${out}/buckets/${id}"
+      mkdir -p "$dir"
+      cp "$rep" "${dir}/input"
+      awk -F'\t' -v b="$id" '$1 == b { print $4 }' "${out}/assign.tsv" > "${dir}/inputs.txt"
+      report="$(awk -F'\t' -v r="$rep" '$1 == r { print $2; exit }' "${out}/index.tsv")"
+      if [[ -f "$report" ]]; then
+        # The representative's report with the binaries' frames symbolized
+        awk -F'\t' '
+          FILENAME ~ /symbols.tsv$/ { sym[$1 "+" $2] = $3 " " $4; next }
+          match($0, /\(.*\+0x[0-9a-f]+\)/) {
+            k = substr($0, RSTART + 1, RLENGTH - 2)
+            if ((k in sym) && (i = index($0, "  (")) > 0) $0 = substr($0, 1, i - 1) " in " sym[k] substr($0, i + 1)
+          }
+          { print }' "${out}/symbols.tsv" "$report" > "${dir}/report.txt"
+      fi
+      printf '%-8s  %6s  %-24s  %s\n%42s%s\n' "$id" "$count" "$type" "$desc" "" "$rep"
+    done < "${out}/buckets.tsv"
+  } > "${out}/summary.txt"
+}
+
+# triage [HARNESS...] [-j N] [--frames N]: replay, dedup and summarize the
+# crashes of every harness with results (or just HARNESS...)
+triage() {
+  local jobs="$(nproc)" frames=3 harnesses=()
+  while (( $# > 0 )); do
+    case "$1" in
+      -j)       jobs="$2"; shift ;;
+      -j*)      jobs="${1#-j}" ;;
+      --frames) frames="$2"; shift ;;
+      *)        harnesses+=("$1") ;;
+    esac
+    shift
+  done
+  if (( ${#harnesses[@]} == 0 )); then
+    local d
+    for d in "$RESULTS"/*/; do
+      [[ -d "${d}crashes" || -d "${d}afl" ]] && harnesses+=("$(basename "$d")")
+    done
+  fi
+  if (( ${#harnesses[@]} == 0 )); then
+    echo "!! no campaign results under ${RESULTS}; run ./fuzz.sh run first"
+    return 1
+  fi
+  local h
+  for h in "${harnesses[@]}"; do
+    local inputs=() f bin
+    while IFS= read -r f; do inputs+=("$f"); done < <(triage_inputs "$h")
+    if (( ${#inputs[@]} == 0 )); then
+      echo "+ [$h] no crashes to triage"
+      continue
+    fi
+    bin="$(bin_for afl "$h")"
+    [[ -n "$bin" ]] || bin="$(bin_for libfuzzer "$h")"
+    if [[ -z "$bin" ]]; then
+      echo "!! [$h] no ASan build to triage with; run ./fuzz.sh build afl (or libfuzzer)"
+      continue
+    fi
+    local out="${RESULTS}/${h}/triage"
+    rm -rf "$out"
+    echo "+ [$h] replaying ${#inputs[@]} crashes through $(basename "$bin") with ${jobs} jobs"
+    triage_replay "$bin" "$out" "$jobs" "${inputs[@]}"
+    triage_bucket "$out" "$frames"
+    echo "+ [$h] $(wc -l < "${out}/index.tsv") crashes reproduced, $(wc -l < "${out}/buckets.tsv") buckets (top ${frames} frames); see ${out}"
+    cat "${out}/summary.txt"
+  done
+}
+
+# -------- Coverage --------
+
+# Seconds one corpus input may run during the coverage replay
+COVERAGE_TIMEOUT=${COVERAGE_TIMEOUT:-10}
+
+# llvm-profdata / llvm-cov matching the clang on PATH: $LLVM_PROFDATA /
+# $LLVM_COV, the unversioned tool, or else the newest versioned one
+llvm_tool() {
+  local override="$2"
+  if [[ -n "$override" ]]; then echo "$override"; return; fi
+  command -v "$1" 2>/dev/null && return
+  compgen -c "$1-" 2>/dev/null | grep -E "^$1-[0-9]+$" | sort -t- -k3,3n | tail -n 1 || true
+}
+
+# Inputs coverage replays for HARNESS: its campaign corpus and testsuite, or
+# the whole testsuite when it has neither
+coverage_corpus() {
+  local harness="$1" found=0 d
+  for d in "${RESULTS}/${harness}/corpus" "${TESTSUITE}/${harness}"; do
+    [[ -d "$d" ]] && { echo "$d"; found=1; }
+  done
+  (( found )) || echo "$TESTSUITE"
+}
+
+# Coverage binaries, one per harness
+coverage_bins() {
+  find_bins coverage | grep -E -- '-coverage$' | LC_ALL=C sort || true
+}
+
+# replay_profiles PROFDATA JOBS BIN...: replays the corpus of each coverage
+# BIN and merges the profiles into PROFDATA, next to which the raw profiles
+# and replay logs are kept. Each harness runs as one driver process whose JOBS
+# forked workers take inputs off a shared queue and write one profile each, so
+# the cost doesn't grow with the number of inputs the way a process (and a
+# profile) per input would. The profiles are merged once at the end.
+replay_profiles() {
+  local profdata="$1" jobs="$2"; shift 2
+  local out raw tool bin h
+  out="$(dirname "$profdata")"
+  raw="${out}/raw"
+  tool="$(llvm_tool llvm-profdata "${LLVM_PROFDATA:-}")"
+  if [[ -z "$tool" ]]; then
+    echo "!! llvm-profdata not found (set LLVM_PROFDATA)"
+    return 1
+  fi
+  (( jobs > 1 )) || jobs=2  # -jobs=1 would replay in-process, so a crash ends the run
+  mkdir -p "$raw"
+  for bin in "$@"; do
+    h="$(harness_of "$bin")"
+    local corpus=() d
+    while IFS= read -r d; do corpus+=("$d"); done < <(coverage_corpus "$h")
+    echo "+ [$h] replaying ${corpus[*]} through $(basename "$bin") on ${jobs} workers"
+    LLVM_PROFILE_FILE="${raw}/${h}-%p.profraw" \
+      "$bin" -jobs="$jobs" -timeout=$(( COVERAGE_TIMEOUT * 1000 )) -rss_limit_mb="$RSS_LIMIT_MB" \
+      "${corpus[@]}" > "${out}/${h}-replay.log" 2>&1 || true
+    # "==driver== N inputs replayed by W worker(s), C crashed"
+    sed -n "s/^==driver== \([0-9]* inputs replayed.*\)$/+ [$h] \1/p" "${out}/${h}-replay.log"
+  done
+
+  local raws=() f
+  while IFS= read -r f; do raws+=("$f"); done < <(find "$raw" -name '*.profraw' | LC_ALL=C sort)
+  if (( ${#raws[@]} == 0 )); then
+    echo "!! the replay wrote no profiles; see ${out}/*-replay.log"
+    return 1
+  fi
+  echo "+ merging ${#raws[@]} profiles into ${profdata}"
+  "$tool" merge -sparse "${raws[@]}" -o "$profdata"
+}
+
+# coverage [HARNESS...] [-j N]: replays the corpus of every harness (or just
+# HARNESS...) through its coverage build and writes one report for all of
+# them to results/coverage
+coverage() {
+  local jobs="$(nproc)" harnesses=()
+  while (( $# > 0 )); do
+    case "$1" in
+      -j)  jobs="$2"; shift ;;
+      -j*) jobs="${1#-j}" ;;
+      *)   harnesses+=("$1") ;;
+    esac
+    shift
+  done
+
+  [[ -n "$(coverage_bins)" ]] || build_engine coverage
+  local bins=() bin
+  while IFS= read -r bin; do
+    [[ -n "$bin" ]] || continue
+    if (( ${#harnesses[@]} > 0 )) && [[ " ${harnesses[*]} " != *" $(harness_of "$bin") "* ]]; then
+      continue
+    fi
+    bins+=("$bin")
+  done < <(coverage_bins)
+  if (( ${#bins[@]} == 0 )); then
+    echo "!! no coverage build${harnesses[*]:+ for ${harnesses[*]}} (needs clang++); see ${RESULTS}/coverage-build.log"
+    return 1
+  fi
+  local cov
+  cov="$(llvm_tool llvm-cov "${LLVM_COV:-}")"
+  if [[ -z "$cov" ]]; then
+    echo "!! llvm-cov not found (set LLVM_COV)"
+    return 1
+  fi
+
+  local out="${RESULTS}/coverage"
+  rm -rf "$out"
+  replay_profiles "${out}/coverage.profdata" "$jobs" "${bins[@]}" || return 1
+
+  # One report across all harnesses; system headers left out
+  local cov_args=("${bins[0]}") o
+  for o in "${bins[@]:1}"; do cov_args+=(-object "$o"); done
+  cov_args+=(-instr-profile="${out}/coverage.profdata" -ignore-filename-regex='^/usr/')
+  "$cov" show "${cov_args[@]}" -format=html -show-line-counts-or-regions -output-dir="${out}/html"
+  "$cov" export "${cov_args[@]}" -format=lcov > "${out}/coverage.lcov"
+  "$cov" report "${cov_args[@]}" | tee "${out}/summary.txt"
+  echo "+ coverage report: ${out}/html/index.html (lcov: ${out}/coverage.lcov)"
+}
+
+# build --pgo, stage 1: trains results/pgo/fuzz.profdata on every harness's
+# corpus with the instrumented coverage build (never --fast), and points
+# PGO_PROFILE at a copy named after its checksum, so a retrained profile changes
+# the compiler flags and the stage 2 trees rebuild
+pgo_train() {
+  [[ -n "$(coverage_bins)" ]] || FAST=0 build_engine coverage
+  local bins=() bin
+  while IFS= read -r bin; do [[ -n "$bin" ]] && bins+=("$bin"); done < <(coverage_bins)
+  if (( ${#bins[@]} == 0 )); then
+    echo "!! --pgo trains with the coverage build (needs clang++); see ${RESULTS}/coverage-build.log"
+    return 1
+  fi
+  local out="${RESULTS}/pgo" sum
+  rm -rf "$out"
+  replay_profiles "${out}/fuzz.profdata" "$(nproc)" "${bins[@]}" || return 1
+  sum="$(cksum < "${out}/fuzz.profdata" | cut -d' ' -f1)"
+  cp "${out}/fuzz.profdata" "${out}/fuzz-${sum}.profdata"
+  PGO_PROFILE="$(realpath "${out}/fuzz-${sum}.profdata")"
+}
+
+# -------- Corpus --------
+
+# Seconds one input may run while `corpus stats` times it
+CORPUS_TIMEOUT=${CORPUS_TIMEOUT:-10}
+
+# Directories `corpus` works on for HARNESS: its testsuite first, so that its
+# copy of a duplicate is the one dedup keeps, then its campaign corpus
+corpus_dirs() {
+  local d
+  for d in "${TESTSUITE}/$1" "${RESULTS}/$1/corpus"; do
+    [[ -d "$d" ]] && echo "$d"
+  done
+  return 0
+}
+
+# corpus stats|dedup [HARNESS...] [-j N]: reports on (stats) or removes the
+# duplicates from (dedup) the testsuite and campaign corpus of every harness
+# (or just HARNESS...) with its standalone driver, hashing on N threads. The
+# report also goes to results/<harness>/corpus-<stats|dedup>.txt.
+corpus() {
+  local action="${1:-}" flag
+  shift || true
+  case "$action" in
+    stats) flag=-corpus_stats=1 ;;
+    dedup) flag=-dedup=1 ;;
+    *)     usage; return 1 ;;
+  esac
+  local jobs="$(nproc)" harnesses=()
+  while (( $# > 0 )); do
+    case "$1" in
+      -j)  jobs="$2"; shift ;;
+      -j*) jobs="${1#-j}" ;;
+      *)   harnesses+=("$1") ;;
+    esac
+    shift
+  done
+
+  [[ -n "$(standalone_bins)" ]] || build_engine standalone
+  if (( ${#harnesses[@]} == 0 )); then
+    local b
+    while IFS= read -r b; do
+      [[ -n "$b" ]] && harnesses+=("$(harness_of "$b")")
+    done < <(standalone_bins)
+  fi
+  if (( ${#harnesses[@]} == 0 )); then
+    echo "!! no standalone build; see ${RESULTS}/standalone-build.log"
+    return 1
+  fi
+  local h
+  for h in "${harnesses[@]}"; do
+    local bin dirs=() d
+    bin="$(bin_for standalone "$h")"
+    if [[ -z "$bin" ]]; then
+      echo "!! [$h] no standalone build"
+      continue
+    fi
+    while IFS= read -r d; do dirs+=("$d"); done < <(corpus_dirs "$h")
+    if (( ${#dirs[@]} == 0 )); then
+      echo "+ [$h] no testsuite or corpus"
+      continue
+    fi
+    mkdir -p "${RESULTS}/${h}"
+    echo "+ [$h] corpus ${action}: ${dirs[*]} on ${jobs} threads"
+    # The driver reports on stderr; the harness's own output is dropped
+    "$bin" "$flag" -jobs="$jobs" -timeout=$(( CORPUS_TIMEOUT * 1000 )) -rss_limit_mb="$RSS_LIMIT_MB" \
+      "${dirs[@]}" 2>&1 >/dev/null | tee "${RESULTS}/${h}/corpus-${action}.txt" \
+      || echo "!! [$h] corpus ${action} failed; see ${RESULTS}/${h}/corpus-${action}.txt"
+  done
+}
+
+# -------- Pack --------
+
+# Packing is built into the replay driver, so any standalone binary will do
+# (named <harness>-native by CMake and <harness>-standalone by make).
+packer_bin() {
+  standalone_bins | head -n 1
+}
+
+pack_dir() {
+  local bin="$1" src="$2" out="$3"
+  mkdir -p "$(dirname "$out")"
+  echo "+ [pack] $src -> $out"
+  "$bin" -pack="$out" "$src"
+}
+
+# Packs DIR into OUT, or each testsuite/<harness> into results/packs/<harness>.fpk
+pack_testsuite() {
+  local src="${1:-}" out="${2:-}"
+  local bin
+  bin="$(packer_bin)"
+  if [[ -z "$bin" ]]; then
+    build_engine standalone
+    bin="$(packer_bin)"
+  fi
+  if [[ -z "$bin" ]]; then
+    echo "!! no standalone binary found; cannot pack"
+    return 1
+  fi
+  if [[ -n "$src" ]]; then
+    pack_dir "$bin" "$src" "${out:-${RESULTS}/packs/$(basename "$src").fpk}"
+    return
+  fi
+  local dir
+  for dir in "$TESTSUITE"/*/; do
+    [[ -d "$dir" ]] || continue
+    pack_dir "$bin" "${dir%/}" "${RESULTS}/packs/$(basename "$dir").fpk"
+  done
+}
+
 # -------- Main --------
 
 mkdir -p ${TESTSUITE}
@@ -193,17 +1165,39 @@ printf 'A%.0s' {1..256} > ${TESTSUITE}/default
 cmd="${1:-}"; shift || true
 case "$cmd" in
   build)
-    engine="${1:-}"
+    args=()
+    for a in "$@"; do
+      case "$a" in
+        --fast)    FAST=1 ;;
+        --pgo)     FAST=1; PGO=1 ;;
+        --thinlto) THINLTO=1 ;;
+        *)         args+=("$a") ;;
+      esac
+    done
+    engine="${args[0]:-}"
+    if [[ -n "$engine" ]]; then
+      if ! is_engine "$engine"; then usage; exit 1; fi
+      if [[ "$FAST" == 1 && "$engine" == "standalone" ]]; then
+        echo "!! standalone has no fast profile"; exit 1
+      fi
+    fi
+    if [[ "$PGO" == 1 ]]; then
+      pgo_train || exit 1
+      echo "+ building with -fprofile-use=${PGO_PROFILE}"
+    fi
     if [[ -z "$engine" ]]; then
       build_all
     else
-      if ! is_engine "$engine"; then usage; exit 1; fi
-      build_engine "$engine"
+      if [[ "$engine" == "afl" ]]; then build_afl; else build_engine "$engine"; fi
     fi
     ;;
   test)
-    engine="${1:-}"
-    secs="${2:-10}"
+    args=()
+    for a in "$@"; do
+      if [[ "$a" == "--force" ]]; then FORCE=1; else args+=("$a"); fi
+    done
+    engine="${args[0]:-}"
+    secs="${args[1]:-10}"
     if [[ -z "$engine" ]]; then
       test_all "$secs"
     else
@@ -216,6 +1210,25 @@ case "$cmd" in
       esac
     fi
     ;;
+  run)
+    args=()
+    for a in "$@"; do
+      if [[ "$a" == "--fast" ]]; then FAST=1; else args+=("$a"); fi
+    done
+    run_campaign "${args[0]:-3600}" "${args[1]:-$(nproc)}"
+    ;;
+  triage)
+    triage "$@"
+    ;;
+  coverage)
+    coverage "$@"
+    ;;
+  corpus)
+    corpus "$@"
+    ;;
+  pack)
+    pack_testsuite "${1:-}" "${2:-}"
+    ;;
   -h|--help|"")
     usage
     ;;
@@ -0,0 +1,80 @@
+#!/usr/bin/env bash
+# Usage: extract_dict.sh OUT.dict FILE...
+#
+# Writes a fuzzing dictionary of the constants compiled into FILE (object
+# files or static libraries, ELF): the immediate operands of compare
+# instructions, as decimal text and as little-endian binary values, and the
+# short strings in their .rodata sections. The build runs this for every
+# harness over the harness object and the library it links; fuzz.sh merges
+# the result with dictionaries/<harness>.dict and passes it to each engine.
+#
+# OBJDUMP and READELF override the tools (e.g. llvm-objdump, llvm-readelf).
+set -euo pipefail
+
+if (( $# < 2 )); then
+  echo "usage: $0 OUT.dict FILE..." >&2
+  exit 2
+fi
+out="$1"; shift
+OBJDUMP=${OBJDUMP:-objdump}
+READELF=${READELF:-readelf}
+export LC_ALL=C
+
+mkdir -p "$(dirname "$out")"
+tmp="${out}.tmp.$$"
+trap 'rm -f "$tmp"' EXIT
+
+{
+  echo "# Generated by extract_dict.sh from: $*"
+
+  # Compare immediates: x86 "cmp $0xfb3c6625,%esi", AArch64 "cmp w1, #0x7"
+  "$OBJDUMP" -d --no-show-raw-insn "$@" 2>/dev/null | awk '
+    function hexval(h,    i, v) {
+      # Low 32 bits only; sign-extended 64-bit immediates end in the same digits
+      h = tolower(h); if (length(h) > 8) h = substr(h, length(h) - 7)
+      v = 0
+      for (i = 1; i <= length(h); i++) v = v * 16 + index("0123456789abcdef", substr(h, i, 1)) - 1
+      return v
+    }
+    function le(v, n,    s, i, b) {
+      s = ""
+      for (i = 0; i < n; i++) { b = v % 256; s = s sprintf("\\x%02x", b); v = (v - b) / 256 }
+      return s
+    }
+    $2 ~ /^(cmp[bwlq]?|cmn|ccmp|ccmn)$/ {
+      if (match($0, /[$#]-?(0x)?[0-9a-fA-F]+/) == 0) next
+      imm = substr($0, RSTART + 1, RLENGTH - 1)
+      neg = (substr(imm, 1, 1) == "-"); if (neg) imm = substr(imm, 2)
+      if (imm ~ /^0x/) v = hexval(substr(imm, 3)); else v = imm + 0
+      if (neg) v = (4294967296 - v) % 4294967296
+      s = (v >= 2147483648) ? v - 4294967296 : v
+      printf "\"%d\"\n", s
+      printf "\"%s\"\n", le(v, 4)
+      if (v < 65536) printf "\"%s\"\n", le(v, 2)
+      if (v < 256) printf "\"%s\"\n", le(v, 1)
+    }'
+
+  # Strings: every .rodata* section, 2 to 32 bytes, minus source paths
+  sections=()
+  while IFS= read -r s; do sections+=(-p "$s"); done < <(
+    "$READELF" -S -W "$@" 2>/dev/null | grep -oE '\.rodata[^ ]*' | sort -u)
+  if (( ${#sections[@]} > 0 )); then
+    "$READELF" -W "${sections[@]}" "$@" 2>/dev/null | awk '
+      BEGIN { for (i = 1; i < 256; i++) ord[sprintf("%c", i)] = i }
+      /^ *\[ *[0-9a-f]+\]  / {
+        s = $0; sub(/^ *\[ *[0-9a-f]+\]  /, "", s)
+        if (length(s) < 2 || length(s) > 32 || substr(s, 1, 1) == "/") next
+        e = ""
+        for (i = 1; i <= length(s); i++) {
+          c = substr(s, i, 1)
+          if (c == "\\" || c == "\"") e = e "\\" c
+          else if (ord[c] < 32 || ord[c] > 126) e = e sprintf("\\x%02x", ord[c])
+          else e = e c
+        }
+        printf "\"%s\"\n", e
+      }'
+  fi
+} | awk '!seen[$0]++' > "$tmp"
+
+mv "$tmp" "$out"
+trap - EXIT
@@ -0,0 +1,153 @@
+#ifndef FUZZ_DATA_PROVIDER_H
+#define FUZZ_DATA_PROVIDER_H
+
+// FuzzedDataProvider for every engine build. clang ships the real one with
+// libFuzzer; other compilers (g++ for the standalone build) get the subset
+// below, which splits the input the same way: integers, floats and bools are
+// taken from the end of the data, strings and byte ranges from the front.
+// The per-function harnesses fuzz-init generates include this header.
+
+#if defined(__has_include)
+#  if __has_include(<fuzzer/FuzzedDataProvider.h>)
+#    include <fuzzer/FuzzedDataProvider.h>
+#    define FUZZ_HAVE_LLVM_DATA_PROVIDER 1
+#  endif
+#endif
+
+#ifndef FUZZ_HAVE_LLVM_DATA_PROVIDER
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class FuzzedDataProvider {
+public:
+    FuzzedDataProvider(const uint8_t* data, size_t size)
+        : data_ptr_(data), remaining_bytes_(size) {}
+
+    size_t remaining_bytes() const { return remaining_bytes_; }
+
+    template <typename T> T ConsumeIntegral() {
+        return ConsumeIntegralInRange(std::numeric_limits<T>::min(),
+                                      std::numeric_limits<T>::max());
+    }
+
+    // Up to sizeof(T) bytes from the end of the data; min once they run out
+    template <typename T> T ConsumeIntegralInRange(T min, T max) {
+        static_assert(std::is_integral<T>::value, "An integral type is required.");
+        if (min > max) return min;
+
+        uint64_t range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+        uint64_t result = 0;
+        size_t offset = 0;
+        while (offset < sizeof(T) * 8 && (range >> offset) > 0 && remaining_bytes_ != 0) {
+            --remaining_bytes_;
+            result = (result << 8) | data_ptr_[remaining_bytes_];
+            offset += 8;
+        }
+        if (range != std::numeric_limits<uint64_t>::max()) result = result % (range + 1);
+        return static_cast<T>(static_cast<uint64_t>(min) + result);
+    }
+
+    bool ConsumeBool() { return 1 & ConsumeIntegral<uint8_t>(); }
+
+    // In [0, 1]
+    template <typename T> T ConsumeProbability() {
+        static_assert(std::is_floating_point<T>::value, "A floating point type is required.");
+        using IntType = typename std::conditional<(sizeof(T) <= sizeof(uint32_t)),
+                                                  uint32_t, uint64_t>::type;
+        T result = static_cast<T>(ConsumeIntegral<IntType>());
+        result /= static_cast<T>(std::numeric_limits<IntType>::max());
+        return result;
+    }
+
+    template <typename T> T ConsumeFloatingPoint() {
+        return ConsumeFloatingPointInRange<T>(std::numeric_limits<T>::lowest(),
+                                              std::numeric_limits<T>::max());
+    }
+
+    template <typename T> T ConsumeFloatingPointInRange(T min, T max) {
+        if (min > max) return min;
+        T range = 0;
+        T result = min;
+        constexpr T zero(.0);
+        if (max > zero && min < zero && max > min + std::numeric_limits<T>::max()) {
+            // The range doesn't fit in T: pick a half, then a point in it
+            range = (max / 2.0) - (min / 2.0);
+            if (ConsumeBool()) result += range;
+        } else {
+            range = max - min;
+        }
+        return result + range * ConsumeProbability<T>();
+    }
+
+    // Bytes up to the next unescaped backslash: "\\" is a literal backslash,
+    // any other "\x" ends the string
+    std::string ConsumeRandomLengthString(size_t max_length) {
+        std::string result;
+        result.reserve(remaining_bytes_ < max_length ? remaining_bytes_ : max_length);
+        for (size_t i = 0; i < max_length && remaining_bytes_ != 0; ++i) {
+            char next = static_cast<char>(data_ptr_[0]);
+            Advance(1);
+            if (next == '\\' && remaining_bytes_ != 0) {
+                next = static_cast<char>(data_ptr_[0]);
+                Advance(1);
+                if (next != '\\') break;
+            }
+            result += next;
+        }
+        return result;
+    }
+
+    std::string ConsumeRandomLengthString() {
+        return ConsumeRandomLengthString(remaining_bytes_);
+    }
+
+    std::string ConsumeBytesAsString(size_t num_bytes) {
+        if (num_bytes > remaining_bytes_) num_bytes = remaining_bytes_;
+        std::string result(reinterpret_cast<const char*>(data_ptr_), num_bytes);
+        Advance(num_bytes);
+        return result;
+    }
+
+    std::string ConsumeRemainingBytesAsString() {
+        return ConsumeBytesAsString(remaining_bytes_);
+    }
+
+    template <typename T> std::vector<T> ConsumeBytes(size_t num_bytes) {
+        static_assert(sizeof(T) == sizeof(uint8_t), "Incompatible data type.");
+        if (num_bytes > remaining_bytes_) num_bytes = remaining_bytes_;
+        std::vector<T> result(num_bytes);
+        if (num_bytes != 0) std::memcpy(result.data(), data_ptr_, num_bytes);
+        Advance(num_bytes);
+        return result;
+    }
+
+    template <typename T> std::vector<T> ConsumeRemainingBytes() {
+        return ConsumeBytes<T>(remaining_bytes_);
+    }
+
+    template <typename T> std::vector<T> ConsumeBytesWithTerminator(size_t num_bytes,
+                                                                    T terminator = 0) {
+        std::vector<T> result = ConsumeBytes<T>(num_bytes);
+        result.push_back(terminator);
+        return result;
+    }
+
+private:
+    void Advance(size_t num_bytes) {
+        data_ptr_ += num_bytes;
+        remaining_bytes_ -= num_bytes;
+    }
+
+    const uint8_t* data_ptr_;
+    size_t remaining_bytes_;
+};
+
+#endif // FUZZ_HAVE_LLVM_DATA_PROVIDER
+
+#endif // FUZZ_DATA_PROVIDER_H
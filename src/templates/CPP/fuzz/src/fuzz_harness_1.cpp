@@ -7,7 +7,6 @@
 
 
 {{#unless minimal}}
-#include <vector>
 #include "mylib.h"
 {{else}}
 // TODO: Include your own header files
@@ -22,19 +21,17 @@
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     {{ #unless minimal }}
     // Example: Process the input data through your library function
-    // Note: Ensure data is properly null-terminated if your function expects a string
+    // Prefer length-aware APIs: functions that need a NUL-terminated copy
+    // cost an allocation and a memcpy on every exec.
     // Reject empty inputs
     if (size == 0) {
         return 0;
     }
 
-    // Allocate a null-terminated buffer with space for the data + '\0'
-    std::vector<char> input_buffer(size + 1, 0);  // zero-initialized
-    std::memcpy(input_buffer.data(), data, size); // copy raw data
-
-    // Call the C function safely
+    // process(data, size) never writes to or reads past the input, so the
+    // fuzzer's buffer can be passed straight through.
     try {
-        return process(input_buffer.data());
+        return process(data, size);
     } catch (...) {
         // Prevent exceptions from escaping; C code shouldn't throw,
         // but just in case anything goes wrong.
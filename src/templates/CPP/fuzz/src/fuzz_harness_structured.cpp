@@ -0,0 +1,181 @@
+{{#unless minimal}}
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <random>
+
+#if defined(__has_include)
+#  if __has_include(<fuzzer/FuzzedDataProvider.h>)
+#    include <fuzzer/FuzzedDataProvider.h>
+#    define HAVE_FUZZED_DATA_PROVIDER 1
+#  endif
+#endif
+
+#include "mylib.h"
+
+// Structure-aware variant of fuzz_harness_1: inputs are still "x,y" records
+// (so the corpus, crashes and testsuite stay readable and replay with the
+// other harness), but every exec reaches the checks behind process()'s
+// format validation.
+//
+//   - Inputs that aren't a well-formed record get their two fields drawn
+//     straight from the bytes with FuzzedDataProvider, so byte-level engines
+//     (AFL++, honggfuzz) don't waste execs on rejected syntax either.
+//   - Under libFuzzer, LLVMFuzzerCustomMutator and LLVMFuzzerCustomCrossOver
+//     mutate the field values and re-serialize the record. The binary field
+//     values also go through LLVMFuzzerMutate, whose table of recent
+//     comparisons supplies magic operands like y == -79927771.
+
+// Provided by libFuzzer only; null in the AFL++/honggfuzz/standalone builds
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t max_size) __attribute__((weak));
+
+namespace {
+
+struct Record {
+    int32_t x;
+    int32_t y;
+};
+
+// Longest serialized record: "-2147483648,-2147483648"
+constexpr size_t kMaxRecordLen = 23;
+
+// Parses exactly "<int>,<int>" with both values in int32 range
+bool parse_record(const uint8_t* data, size_t size, Record* r) {
+    if (size == 0 || size > kMaxRecordLen) return false;
+    char buf[kMaxRecordLen + 1];
+    std::memcpy(buf, data, size);
+    buf[size] = '\0';
+
+    char* comma = std::strchr(buf, ',');
+    if (comma == NULL || comma == buf || comma[1] == '\0') return false;
+    *comma = '\0';
+
+    char* end;
+    long x = std::strtol(buf, &end, 10);
+    if (*end != '\0' || x < INT32_MIN || x > INT32_MAX) return false;
+    long y = std::strtol(comma + 1, &end, 10);
+    if (*end != '\0' || y < INT32_MIN || y > INT32_MAX) return false;
+
+    r->x = (int32_t)x;
+    r->y = (int32_t)y;
+    return true;
+}
+
+// Draws both fields from arbitrary bytes
+Record draw_record(const uint8_t* data, size_t size) {
+    Record r;
+#if HAVE_FUZZED_DATA_PROVIDER
+    FuzzedDataProvider fdp(data, size);
+    r.x = fdp.ConsumeIntegral<int32_t>();
+    r.y = fdp.ConsumeIntegral<int32_t>();
+#else
+    // What FuzzedDataProvider::ConsumeIntegral<int32_t>() does, for compilers
+    // without clang's header: up to 4 bytes taken from the end of the data.
+    int32_t* fields[2] = {&r.x, &r.y};
+    for (int32_t* field : fields) {
+        uint32_t raw = 0;
+        for (int i = 0; i < 4 && size > 0; i++) {
+            raw = (raw << 8) | data[--size];
+        }
+        *field = (int32_t)((uint32_t)INT32_MIN + raw);
+    }
+#endif
+    return r;
+}
+
+Record load_record(const uint8_t* data, size_t size) {
+    Record r;
+    if (!parse_record(data, size, &r)) r = draw_record(data, size);
+    return r;
+}
+
+// Writes "x,y" to out; returns its length, or 0 if it doesn't fit
+size_t serialize(const Record& r, uint8_t* out, size_t max_size) {
+    char buf[kMaxRecordLen + 1];
+    int len = std::snprintf(buf, sizeof(buf), "%d,%d", (int)r.x, (int)r.y);
+    if (len <= 0 || (size_t)len > max_size) return 0;
+    std::memcpy(out, buf, (size_t)len);
+    return (size_t)len;
+}
+
+void mutate_field(int32_t* field, std::minstd_rand& rng) {
+    static const int32_t kInteresting[] = {
+        0, 1, -1, 2, 3, 4, 5, 6, 7, 8, 16, 32, 64, 100, 127, -128, 255, 256,
+        1000, 1024, 4096, 32767, -32768, 65535, 65536, INT32_MAX, INT32_MIN,
+    };
+    switch (rng() % 4) {
+    case 0: // small step
+        *field = (int32_t)((uint32_t)*field + (uint32_t)((int32_t)(rng() % 33) - 16));
+        break;
+    case 1: // bit flip
+        *field = (int32_t)((uint32_t)*field ^ (1u << (rng() % 32)));
+        break;
+    case 2: // boundary value
+        *field = kInteresting[rng() % (sizeof(kInteresting) / sizeof(kInteresting[0]))];
+        break;
+    default: // negate
+        *field = (int32_t)(0u - (uint32_t)*field);
+        break;
+    }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    Record r = load_record(data, size);
+
+    uint8_t record[kMaxRecordLen];
+    size_t len = serialize(r, record, sizeof(record));
+    return process(record, len);
+}
+
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t max_size,
+                                          unsigned int seed) {
+    std::minstd_rand rng(seed);
+    Record r = load_record(data, size);
+
+    switch (rng() % 4) {
+    case 0:
+        if (LLVMFuzzerMutate) {
+            // libFuzzer's own mutations, comparison operands included, on the
+            // binary field values
+            uint8_t raw[sizeof(Record)];
+            std::memcpy(raw, &r, sizeof(r));
+            LLVMFuzzerMutate(raw, sizeof(raw), sizeof(raw));
+            std::memcpy(&r, raw, sizeof(r));
+            break;
+        }
+        mutate_field(&r.y, rng);
+        break;
+    case 1:
+        mutate_field(&r.x, rng);
+        break;
+    case 2:
+        mutate_field(&r.y, rng);
+        break;
+    default:
+        mutate_field(&r.x, rng);
+        mutate_field(&r.y, rng);
+        break;
+    }
+
+    size_t len = serialize(r, data, max_size);
+    return len ? len : size;
+}
+
+extern "C" size_t LLVMFuzzerCustomCrossOver(const uint8_t* data1, size_t size1,
+                                            const uint8_t* data2, size_t size2,
+                                            uint8_t* out, size_t max_out_size,
+                                            unsigned int seed) {
+    std::minstd_rand rng(seed);
+    Record a = load_record(data1, size1);
+    Record b = load_record(data2, size2);
+
+    // One field from each parent
+    Record child = (rng() & 1) ? Record{a.x, b.y} : Record{b.x, a.y};
+    return serialize(child, out, max_out_size);
+}
+{{/unless}}
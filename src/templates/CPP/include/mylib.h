@@ -1,5 +1,7 @@
 #ifndef LIB_H
 #define LIB_H
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 /**
@@ -15,6 +17,55 @@
  // regular C++ declarations.
 
 int process(char* input);
+
+/**
+ * Length-aware variant of process(char*) for raw, possibly unterminated input.
+ *
+ * The input is split into fields without being modified and the integers
+ * are parsed from bounded ranges, so callers can pass a fuzzer's buffer
+ * directly. Embedded NULs are ordinary bytes, and integers that don't fit an
+ * int parse as 0.
+ */
+int process(const uint8_t* data, size_t size);
+
+/**
+ * Finds every `delim` byte in data[0, size).
+ *
+ * The offsets of the first `max_offsets` matches are stored in `offsets`,
+ * in order; the return value is the total number of matches, which may be
+ * larger. Scans 16 or 32 bytes at a time with SSE2/AVX2/NEON when the
+ * compiler targets them, and byte by byte in fuzzing builds
+ * (FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION) so every comparison gives
+ * coverage feedback, unless MYLIB_VECTOR_SCAN=1 is also defined.
+ */
+size_t find_delimiters(const uint8_t* data, size_t size, uint8_t delim,
+                       size_t* offsets, size_t max_offsets);
+
+/**
+ * Counters for multi-record processing. Zero-initialize before first use;
+ * the functions below add to them.
+ */
+struct StreamStats {
+    uint64_t records; // non-empty records seen
+    uint64_t errors;  // records process() rejected
+    uint64_t bytes;   // input bytes consumed
+};
+
+/**
+ * Processes every newline-delimited record in data[0, size), as if each one
+ * were passed to process(data, size) (a trailing '\r' is stripped, empty
+ * lines are skipped). Rejected records are counted instead of printed.
+ */
+void process_records(const uint8_t* data, size_t size, StreamStats* stats);
+
+/**
+ * Reads fd (a file or a pipe) to EOF and processes each record in it.
+ *
+ * Input is read in large blocks into one reused buffer; only a record that
+ * straddles two blocks is moved, and the buffer only grows for records
+ * longer than a block. Returns 0, or -1 if reading fails.
+ */
+int process_stream(int fd, StreamStats* stats);
 void divide_by_zero_bug(int x, int y);
 void integer_overflow_bug(int x, int y);
 void oob_read_bug(int x, int y);
@@ -4,15 +4,52 @@
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <chrono>
 #include <unistd.h>
 #include <fcntl.h>
 
+// --stream [FILE]: process every record in FILE (or stdin) and report throughput
+static int run_stream(const char* path) {
+    int fd = STDIN_FILENO;
+    if (path != NULL) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open file '" << path << "'" << std::endl;
+            return -1;
+        }
+    }
+
+    StreamStats stats = {0, 0, 0};
+    auto start = std::chrono::steady_clock::now();
+    int rc = process_stream(fd, &stats);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (path != NULL) {
+        close(fd);
+    }
+    if (rc != 0) {
+        std::cerr << "Error: Failed reading " << (path ? path : "stdin") << std::endl;
+        return -1;
+    }
+
+    std::cout << "Processed " << stats.records << " records (" << stats.errors
+              << " rejected, " << stats.bytes << " bytes) in " << seconds << " s";
+    if (seconds > 0) {
+        std::cout << ": " << static_cast<uint64_t>(stats.records / seconds) << " records/s";
+    }
+    std::cout << std::endl;
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
     char input[64];
     int fd = STDIN_FILENO;
     ssize_t bytes_read = 0;
 
+    if (argc >= 2 && strcmp(argv[1], "--stream") == 0) {
+        return run_stream(argc >= 3 ? argv[2] : NULL);
+    }
+
     if (argc == 2) {
         std::cout << "Hello fuzz world! Reading from file " << argv[1] << std::endl;
         fd = open(argv[1], O_RDONLY);
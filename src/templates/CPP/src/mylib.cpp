@@ -4,6 +4,31 @@
 #include <string.h>
 #include <unistd.h>
 #include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <charconv>
+
+// Vector width for find_delimiters(). Fuzzing builds keep the scalar loop:
+// one branch per byte gives the fuzzer coverage feedback that a single
+// vector compare would hide. MYLIB_VECTOR_SCAN=1 keeps the vector loop in a
+// fuzzing build (the honggfuzz builds), so the code that ships gets fuzzed too.
+#if defined(FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION) && !MYLIB_VECTOR_SCAN
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define MYLIB_SCAN_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MYLIB_SCAN_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MYLIB_SCAN_NEON 1
+#endif
+
+// Longest record process(char*) splits; more fields are an input error.
+#define MAX_FIELDS 15
+
+// Read size for process_stream()
+#define STREAM_BLOCK_SIZE (1 << 20)
 
 // Helper functions for vulnerable behaviors
 void divide_by_zero_bug(int x, int y) {
@@ -61,36 +86,212 @@ void assert_bug(int x, int y) {
     }
 }
 
-int process(char* input) {
-    char* str = NULL;
-    char* fields[2];
-    int field_count = 0;
+static void run_checks(int x, int y) {
+    divide_by_zero_bug(x, y);
+    integer_overflow_bug(x, y);
+    oob_read_bug(x, y);
+    oob_write_bug(x, y);
+    double_free_bug(x, y);
+    stack_exhaustion_bug(x, y);
+    assert_bug(x, y);
+}
+
+// Parses the leading integer of [first, last) the way atoi() does: optional
+// whitespace and sign, then digits, with anything else ignored.
+static int parse_int(const char* first, const char* last) {
+    while (first != last && isspace((unsigned char)*first)) {
+        first++;
+    }
+    if (first != last && *first == '+') {
+        first++;
+        if (first != last && *first == '-') {
+            return 0; // "+-1" is not a number for atoi() either
+        }
+    }
+    int value = 0;
+    std::from_chars(first, last, value);
+    return value;
+}
+
+#if MYLIB_SCAN_AVX2 || MYLIB_SCAN_SSE2 || MYLIB_SCAN_NEON
+// Stores base + the index of each set bit of mask (lowest first).
+// `stride` is the number of mask bits per input byte.
+static size_t emit_offsets(uint64_t mask, unsigned stride, size_t base,
+                           size_t* offsets, size_t max_offsets, size_t count) {
+    while (mask) {
+        if (count < max_offsets) {
+            offsets[count] = base + (size_t)__builtin_ctzll(mask) / stride;
+        }
+        count++;
+        mask &= mask - 1;
+    }
+    return count;
+}
+#endif
+
+size_t find_delimiters(const uint8_t* data, size_t size, uint8_t delim,
+                       size_t* offsets, size_t max_offsets) {
+    size_t count = 0;
+    size_t i = 0;
 
-    str = input;
+#if MYLIB_SCAN_AVX2
+    const __m256i needle = _mm256_set1_epi8((char)delim);
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+        count = emit_offsets(mask, 1, i, offsets, max_offsets, count);
+    }
+#elif MYLIB_SCAN_SSE2
+    const __m128i needle = _mm_set1_epi8((char)delim);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        count = emit_offsets(mask, 1, i, offsets, max_offsets, count);
+    }
+#elif MYLIB_SCAN_NEON
+    const uint8x16_t needle = vdupq_n_u8(delim);
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(data + i), needle);
+        // NEON has no movemask: shift-narrow each byte to a nibble, giving a
+        // 64-bit mask with 4 bits per input byte, then keep one bit of each.
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+        count = emit_offsets(mask, 4, i, offsets, max_offsets, count);
+    }
+#endif
 
-    fields[field_count++] = str;
-    for (char* ptr = str; *ptr != '\0' && field_count < 15; ptr++) {
-        if (*ptr == ',') {
-            *ptr = '\0'; // Terminate the current field
-            fields[field_count++] = ptr + 1; // Start of the next field
+    for (; i < size; i++) {
+        if (data[i] == delim) {
+            if (count < max_offsets) {
+                offsets[count] = i;
+            }
+            count++;
         }
     }
-    if (field_count == 2) {
+    return count;
+}
 
-        int x = atoi(fields[0]);
-        int y = atoi(fields[1]);
+int process(char* input) {
+    size_t commas[MAX_FIELDS - 1];
+    size_t comma_count = find_delimiters((const uint8_t*)input, strlen(input), ',',
+                                         commas, MAX_FIELDS - 1);
 
-        divide_by_zero_bug(x, y);
-        integer_overflow_bug(x, y);
-        oob_read_bug(x, y);
-        oob_write_bug(x, y);
-        double_free_bug(x, y);
-        stack_exhaustion_bug(x, y);
-        assert_bug(x, y);
+    // Terminate each field in place (at most MAX_FIELDS of them)
+    for (size_t i = 0; i < comma_count && i < MAX_FIELDS - 1; i++) {
+        input[commas[i]] = '\0';
+    }
+
+    if (comma_count == 1) {
+
+        int x = atoi(input);
+        int y = atoi(input + commas[0] + 1);
+
+        run_checks(x, y);
     }
     else {
         printf("Error: Invalid input format. Expected two comma-separated integers.\n");
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+static int process_record(const uint8_t* data, size_t size, bool report_errors) {
+    const char* input = (const char*)data;
+    const char* end = input + size;
+
+    // Exactly two fields, i.e. exactly one comma.
+    size_t comma = 0;
+    if (find_delimiters(data, size, ',', &comma, 1) != 1) {
+        if (report_errors) {
+            printf("Error: Invalid input format. Expected two comma-separated integers.\n");
+        }
+        return -1;
+    }
+
+    int x = parse_int(input, input + comma);
+    int y = parse_int(input + comma + 1, end);
+
+    run_checks(x, y);
+    return 0;
+}
+
+int process(const uint8_t* data, size_t size) {
+    return process_record(data, size, true);
+}
+
+void process_records(const uint8_t* data, size_t size, StreamStats* stats) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+
+    while (p < end) {
+        const uint8_t* nl = (const uint8_t*)memchr(p, '\n', end - p);
+        size_t len = (nl ? nl : end) - p;
+        if (len > 0 && p[len - 1] == '\r') {
+            len--;
+        }
+        if (len > 0) {
+            stats->records++;
+            if (process_record(p, len, false) != 0) {
+                stats->errors++;
+            }
+        }
+        p = nl ? nl + 1 : end;
+    }
+    stats->bytes += size;
+}
+
+int process_stream(int fd, StreamStats* stats) {
+    size_t cap = STREAM_BLOCK_SIZE;
+    size_t len = 0; // buffered bytes; everything before `len` lacks a newline
+    uint8_t* buf = (uint8_t*)malloc(cap);
+    if (buf == NULL) {
+        return -1;
+    }
+
+    for (;;) {
+        if (len == cap) {
+            // A single record is longer than the buffer
+            uint8_t* bigger = (uint8_t*)realloc(buf, cap * 2);
+            if (bigger == NULL) {
+                free(buf);
+                return -1;
+            }
+            buf = bigger;
+            cap *= 2;
+        }
+
+        ssize_t n = read(fd, buf + len, cap - len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            free(buf);
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        // Only the new bytes can hold the last newline
+        size_t old_len = len;
+        len += (size_t)n;
+        size_t complete = len;
+        while (complete > old_len && buf[complete - 1] != '\n') {
+            complete--;
+        }
+        if (complete == old_len) {
+            continue;
+        }
+
+        process_records(buf, complete, stats);
+        memmove(buf, buf + complete, len - complete);
+        len -= complete;
+    }
+
+    // Final record without a trailing newline
+    if (len > 0) {
+        process_records(buf, len, stats);
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,378 @@
+{{#unless minimal}}
+// Microbenchmarks for the library: process(), its length-aware overload and
+// process_records() over the test_data/*.nmea inputs and a few large
+// synthetic records. Each benchmark reports ns/op, throughput and
+// allocations/op, and is compared against a baseline file; the exit status
+// is 1 when one got slower than -max_slowdown allows, allocates more, or
+// has no timing in the baseline.
+//
+//   bench_lib [flags] [TEST_DATA_DIR]
+//     -baseline=FILE       baseline to compare against (default: none)
+//     -update_baseline=1   write the measured numbers to -baseline instead
+//     -max_slowdown=PCT    allowed ns/op increase over the baseline (25)
+//     -min_time_ms=MS      minimum run time of each repetition (100)
+//     -repetitions=N       repetitions per benchmark; the fastest counts (5)
+//
+// Baseline lines are "NAME NS_PER_OP ALLOCS_PER_OP". Timings only mean
+// something on the machine they were recorded on; a "-" for NS_PER_OP fails
+// the gate until the baseline is re-recorded there with -update_baseline=1.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "mylib.h"
+
+// Allocations are counted by interposing glibc's malloc, calloc, realloc and
+// free, as the fuzz driver's -malloc_stats does. Sanitizer builds have their
+// own allocator and other C libraries have no __libc_malloc, so they report
+// no allocation numbers (-DBENCH_INTERPOSE_MALLOC=0 turns counting off).
+#if defined(__has_feature)
+#  if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || __has_feature(thread_sanitizer)
+#    define BENCH_HAS_ALLOCATOR_SANITIZER 1
+#  endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#  define BENCH_HAS_ALLOCATOR_SANITIZER 1
+#endif
+#ifndef BENCH_INTERPOSE_MALLOC
+#  if defined(__GLIBC__) && !defined(BENCH_HAS_ALLOCATOR_SANITIZER)
+#    define BENCH_INTERPOSE_MALLOC 1
+#  else
+#    define BENCH_INTERPOSE_MALLOC 0
+#  endif
+#endif
+
+static uint64_t g_allocs = 0;
+
+#if BENCH_INTERPOSE_MALLOC
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void __libc_free(void*);
+
+void* malloc(size_t n) noexcept {
+    ++g_allocs;
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t m) noexcept {
+    ++g_allocs;
+    return __libc_calloc(n, m);
+}
+
+void* realloc(void* p, size_t n) noexcept {
+    if (!p) ++g_allocs;
+    return __libc_realloc(p, n);
+}
+
+void free(void* p) noexcept {
+    __libc_free(p);
+}
+}
+#endif
+
+// The report goes here; stdout itself goes to /dev/null, so the error
+// messages process() prints for rejected input cost a buffered write, not
+// a terminal round trip
+static FILE* g_out = stdout;
+
+struct Benchmark {
+    std::string name;
+    std::string input;
+    int (*run)(const std::string& input, std::vector<char>& scratch);
+};
+
+struct Result {
+    double ns_per_op;
+    double bytes_per_sec;
+    double allocs_per_op;
+};
+
+struct Baseline {
+    bool has_ns;
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+// process(char*) modifies its input, so every op includes copying it back
+static int run_process_cstr(const std::string& input, std::vector<char>& scratch) {
+    std::memcpy(scratch.data(), input.c_str(), input.size() + 1);
+    return process(scratch.data());
+}
+
+static int run_process_len(const std::string& input, std::vector<char>&) {
+    return process(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+static int run_process_records(const std::string& input, std::vector<char>&) {
+    StreamStats stats = {0, 0, 0};
+    process_records(reinterpret_cast<const uint8_t*>(input.data()), input.size(), &stats);
+    return static_cast<int>(stats.errors);
+}
+
+static bool read_file(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+// The *.nmea files in dir, sorted by name
+static std::vector<std::string> list_inputs(const std::string& dir) {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (d == NULL) return names;
+    while (struct dirent* entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".nmea") == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static std::vector<Benchmark> make_benchmarks(const std::string& data_dir) {
+    std::vector<Benchmark> benchmarks;
+    std::string all_records;
+    for (const std::string& name : list_inputs(data_dir)) {
+        std::string input;
+        if (!read_file(data_dir + "/" + name, input)) continue;
+        benchmarks.push_back({"process_cstr/" + name, input, run_process_cstr});
+        benchmarks.push_back({"process_len/" + name, input, run_process_len});
+        all_records += input;
+    }
+    if (!all_records.empty()) {
+        benchmarks.push_back({"process_records/test_data", all_records, run_process_records});
+    }
+
+    // Two fields, the second 64 KiB of digits: one long integer parse.
+    // x = 10 stays clear of the planted bugs.
+    std::string long_field = "10," + std::string(64 * 1024, '0') + "20";
+    benchmarks.push_back({"process_cstr/long_field", long_field, run_process_cstr});
+    benchmarks.push_back({"process_len/long_field", long_field, run_process_len});
+
+    // 64 KiB of fields: the delimiter scan over a record that gets rejected
+    std::string many_fields;
+    while (many_fields.size() < 64 * 1024) many_fields += "1234,";
+    benchmarks.push_back({"process_cstr/many_fields", many_fields, run_process_cstr});
+    benchmarks.push_back({"process_len/many_fields", many_fields, run_process_len});
+
+    // 16Ki short records
+    std::string records;
+    for (int i = 0; i < 16 * 1024; i++) records += "10,20\n";
+    benchmarks.push_back({"process_records/16k_records", records, run_process_records});
+
+    return benchmarks;
+}
+
+static double run_for(const Benchmark& benchmark, std::vector<char>& scratch, uint64_t iterations,
+                      uint64_t* allocs) {
+    volatile int sink = 0;
+    uint64_t allocs_before = g_allocs;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        sink = sink + benchmark.run(benchmark.input, scratch);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    *allocs = g_allocs - allocs_before;
+    return ns;
+}
+
+static Result measure(const Benchmark& benchmark, double min_time_ns, int repetitions) {
+    std::vector<char> scratch(benchmark.input.size() + 1);
+    uint64_t allocs = 0;
+
+    // Double the iterations until one repetition takes min_time_ns
+    uint64_t iterations = 1;
+    while (run_for(benchmark, scratch, iterations, &allocs) < min_time_ns && iterations < (1ull << 40)) {
+        iterations *= 2;
+    }
+
+    double best_ns = 0;
+    for (int rep = 0; rep < repetitions; rep++) {
+        double ns = run_for(benchmark, scratch, iterations, &allocs);
+        if (rep == 0 || ns < best_ns) best_ns = ns;
+    }
+
+    Result result;
+    result.ns_per_op = best_ns / iterations;
+    result.bytes_per_sec = benchmark.input.size() * 1e9 / result.ns_per_op;
+    result.allocs_per_op = static_cast<double>(allocs) / iterations;
+    return result;
+}
+
+static bool read_baseline(const std::string& path, std::map<std::string, Baseline>& baseline) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name, ns, allocs;
+        if (!(fields >> name >> ns >> allocs)) continue;
+        Baseline entry;
+        entry.has_ns = ns != "-";
+        entry.ns_per_op = entry.has_ns ? std::atof(ns.c_str()) : 0;
+        entry.allocs_per_op = std::atof(allocs.c_str());
+        baseline[name] = entry;
+    }
+    return true;
+}
+
+static bool write_baseline(const std::string& path, const std::vector<Benchmark>& benchmarks,
+                           const std::vector<Result>& results) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == NULL) return false;
+    std::fprintf(file, "# bench_lib baseline: NAME NS_PER_OP ALLOCS_PER_OP\n");
+    std::fprintf(file, "# Re-record on the machine that runs the gate after intended changes.\n");
+    for (size_t i = 0; i < benchmarks.size(); i++) {
+        std::fprintf(file, "%s %.1f %.2f\n", benchmarks[i].name.c_str(), results[i].ns_per_op,
+                     results[i].allocs_per_op);
+    }
+    return std::fclose(file) == 0;
+}
+
+static bool parse_flag(const char* arg, const char* name, std::string* value) {
+    size_t len = std::strlen(name);
+    if (arg[0] != '-' || std::strncmp(arg + 1, name, len) != 0 || arg[len + 1] != '=') return false;
+    *value = arg + len + 2;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string data_dir = "../test_data";
+    std::string baseline_path;
+    bool update_baseline = false;
+    double max_slowdown = 25;
+    double min_time_ms = 100;
+    int repetitions = 5;
+
+    for (int i = 1; i < argc; i++) {
+        std::string value;
+        if (parse_flag(argv[i], "baseline", &value)) baseline_path = value;
+        else if (parse_flag(argv[i], "update_baseline", &value)) update_baseline = value == "1";
+        else if (parse_flag(argv[i], "max_slowdown", &value)) max_slowdown = std::atof(value.c_str());
+        else if (parse_flag(argv[i], "min_time_ms", &value)) min_time_ms = std::atof(value.c_str());
+        else if (parse_flag(argv[i], "repetitions", &value)) repetitions = std::max(1, std::atoi(value.c_str()));
+        else if (argv[i][0] == '-') {
+            std::fprintf(stderr, "Unknown flag: %s\n", argv[i]);
+            return 2;
+        } else data_dir = argv[i];
+    }
+    if (update_baseline && baseline_path.empty()) {
+        std::fprintf(stderr, "-update_baseline=1 needs -baseline=FILE\n");
+        return 2;
+    }
+
+    std::map<std::string, Baseline> baseline;
+    if (!baseline_path.empty() && !update_baseline && !read_baseline(baseline_path, baseline)) {
+        std::fprintf(stderr, "Could not read baseline %s\n", baseline_path.c_str());
+        return 2;
+    }
+
+    std::vector<Benchmark> benchmarks = make_benchmarks(data_dir);
+    if (list_inputs(data_dir).empty()) {
+        std::fprintf(stderr, "Warning: no *.nmea inputs in %s\n", data_dir.c_str());
+    }
+
+    std::fflush(stdout);
+    int out_fd = dup(STDOUT_FILENO);
+    g_out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+    if (g_out == NULL || std::freopen("/dev/null", "w", stdout) == NULL) {
+        std::fprintf(stderr, "Could not redirect stdout\n");
+        return 2;
+    }
+
+    std::fprintf(g_out, "bench_lib: %zu benchmarks, fastest of %d x %.0f ms", benchmarks.size(), repetitions,
+                 min_time_ms);
+    if (!baseline.empty()) std::fprintf(g_out, ", max slowdown %.0f%%", max_slowdown);
+    std::fprintf(g_out, "\n%-36s %12s %10s %10s  %s\n", "benchmark", "ns/op", "MB/s", "allocs/op", "baseline");
+
+    std::vector<Result> results;
+    int regressions = 0;
+    int untimed = 0;
+    for (const Benchmark& benchmark : benchmarks) {
+        std::map<std::string, Baseline>::const_iterator base = baseline.find(benchmark.name);
+        Result result = measure(benchmark, min_time_ms * 1e6, repetitions);
+
+        // A slowdown has to survive two more measurements to count, so a
+        // burst of load on the machine doesn't fail the gate
+        for (int retry = 0; retry < 2 && base != baseline.end() && base->second.has_ns &&
+                            result.ns_per_op > base->second.ns_per_op * (1 + max_slowdown / 100);
+             retry++) {
+            Result again = measure(benchmark, min_time_ms * 1e6, repetitions);
+            if (again.ns_per_op < result.ns_per_op) result = again;
+        }
+        results.push_back(result);
+
+        std::fprintf(g_out, "%-36s %12.1f %10.1f ", benchmark.name.c_str(), result.ns_per_op,
+                     result.bytes_per_sec / 1e6);
+        if (BENCH_INTERPOSE_MALLOC) std::fprintf(g_out, "%10.2f  ", result.allocs_per_op);
+        else std::fprintf(g_out, "%10s  ", "-");
+
+        if (base == baseline.end()) {
+            std::fprintf(g_out, "%s\n", baseline.empty() ? "" : "(new)");
+            continue;
+        }
+        bool regressed = false;
+        if (base->second.has_ns) {
+            double change = (result.ns_per_op / base->second.ns_per_op - 1) * 100;
+            std::fprintf(g_out, "%.1f (%+.1f%%)", base->second.ns_per_op, change);
+            regressed = change > max_slowdown;
+        } else {
+            std::fprintf(g_out, "-");
+        }
+        // Allocation counts are exact, so any increase is a regression
+        if (BENCH_INTERPOSE_MALLOC && result.allocs_per_op > base->second.allocs_per_op + 0.005) {
+            std::fprintf(g_out, ", allocs %.2f -> %.2f", base->second.allocs_per_op, result.allocs_per_op);
+            regressed = true;
+        }
+        if (regressed) {
+            std::fprintf(g_out, "  REGRESSION");
+            regressions++;
+        }
+        if (!base->second.has_ns) {
+            std::fprintf(g_out, "  NO TIMING");
+            untimed++;
+        }
+        std::fprintf(g_out, "\n");
+    }
+
+    if (update_baseline) {
+        if (!write_baseline(baseline_path, benchmarks, results)) {
+            std::fprintf(stderr, "Could not write baseline %s\n", baseline_path.c_str());
+            return 2;
+        }
+        std::fprintf(g_out, "Wrote baseline %s\n", baseline_path.c_str());
+        return 0;
+    }
+    if (baseline.empty()) {
+        std::fprintf(g_out, "No baseline to compare against\n");
+        return 0;
+    }
+    if (untimed > 0) {
+        std::fprintf(g_out, "%d benchmark(s) have no timing in %s; re-record it with -update_baseline=1\n",
+                     untimed, baseline_path.c_str());
+    }
+    if (regressions > 0) {
+        std::fprintf(g_out, "%d benchmark(s) regressed against %s\n", regressions, baseline_path.c_str());
+    }
+    if (untimed > 0 || regressions > 0) return 1;
+    std::fprintf(g_out, "All benchmarks within baseline\n");
+    return 0;
+}
+{{/unless}}
@@ -5,7 +5,8 @@
 #include <cstring>
 #include <cassert>
 #include <string>
-#include "lib.h"
+#include <unistd.h>
+#include "mylib.h"
 
 // Simple test framework macros
 #define TEST_PASSED 0
@@ -115,6 +116,111 @@ int test_string_modification() {
     return TEST_PASSED;
 }
 
+// Test the length-aware process(data, size) overload
+int test_process_length_aware() {
+    const char valid[] = "10,20";
+    const char invalid[] = "1,2,3";
+
+    if (process((const uint8_t*)valid, std::strlen(valid)) != 0) return TEST_FAILED;
+    if (process((const uint8_t*)invalid, std::strlen(invalid)) != -1) return TEST_FAILED;
+    if (process((const uint8_t*)"", 0) != -1) return TEST_FAILED;
+
+    // Only the first size bytes count: "1,2" within "1,2,3"
+    if (process((const uint8_t*)invalid, 3) != 0) return TEST_FAILED;
+    // ...and a comma just past the end isn't a field separator
+    if (process((const uint8_t*)"9,", 1) != -1) return TEST_FAILED;
+
+    return TEST_PASSED;
+}
+
+// The length-aware overload must leave its input untouched
+int test_process_length_aware_no_modification() {
+    char input[] = "  5  ,  10  ";
+    char original[] = "  5  ,  10  ";
+
+    if (process((const uint8_t*)input, std::strlen(input)) != 0) return TEST_FAILED;
+    if (std::strcmp(input, original) != 0) return TEST_FAILED;
+
+    return TEST_PASSED;
+}
+
+// Test find_delimiters() against a byte-by-byte scan, across vector-width
+// boundaries and with more matches than the offsets array holds
+int test_find_delimiters() {
+    uint8_t data[200];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (i % 7 == 0 || i % 31 == 0) ? ',' : 'a';
+    }
+
+    for (size_t size = 0; size <= sizeof(data); size++) {
+        size_t offsets[64];
+        size_t count = find_delimiters(data, size, ',', offsets, 64);
+
+        size_t expected = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] != ',') continue;
+            if (expected < 64 && offsets[expected] != i) return TEST_FAILED;
+            expected++;
+        }
+        if (count != expected) return TEST_FAILED;
+    }
+
+    // max_offsets of 0 still counts every match
+    if (find_delimiters(data, sizeof(data), ',', NULL, 0) == 0) return TEST_FAILED;
+
+    return TEST_PASSED;
+}
+
+// Records with many fields are rejected instead of overflowing the field list
+int test_process_many_fields() {
+    char input[] = "GPGGA,123456.78,1234,N,5678,W,1,08,0.9,545.4,M,46.9,M,,*47";
+    const char* record = "GPGGA,123456.78,1234,N,5678,W,1,08,0.9,545.4,M,46.9,M,,*47";
+
+    if (process(input) != -1) return TEST_FAILED;
+    if (process((const uint8_t*)record, std::strlen(record)) != -1) return TEST_FAILED;
+
+    return TEST_PASSED;
+}
+
+// Test process_records() record splitting and error counting
+int test_process_records() {
+    const char* input = "0,1\r\n10,20\n\nnot a record\n1,2,3\n-5,15";
+    StreamStats stats = {0, 0, 0};
+
+    process_records((const uint8_t*)input, std::strlen(input), &stats);
+    if (stats.records != 5) return TEST_FAILED;
+    if (stats.errors != 2) return TEST_FAILED;
+    if (stats.bytes != std::strlen(input)) return TEST_FAILED;
+
+    return TEST_PASSED;
+}
+
+// Test process_stream() with records straddling its read blocks
+int test_process_stream() {
+    const size_t count = 300000; // several MiB, more than one block
+    FILE* f = tmpfile();
+    if (f == NULL) return TEST_FAILED;
+
+    for (size_t i = 0; i < count; i++) {
+        std::fputs(i % 1000 == 0 ? "bad\n" : "10,20\n", f);
+    }
+    std::fputs("-5,15", f); // no trailing newline
+    std::fflush(f);
+    long size = std::ftell(f);
+    if (lseek(fileno(f), 0, SEEK_SET) != 0) { std::fclose(f); return TEST_FAILED; }
+
+    StreamStats stats = {0, 0, 0};
+    int rc = process_stream(fileno(f), &stats);
+    std::fclose(f);
+
+    if (rc != 0) return TEST_FAILED;
+    if (stats.records != count + 1) return TEST_FAILED;
+    if (stats.errors != count / 1000) return TEST_FAILED;
+    if (stats.bytes != (uint64_t)size) return TEST_FAILED;
+
+    return TEST_PASSED;
+}
+
 int main() {
     std::cout << "=== {{project_name}} Library Test Suite ===" << std::endl << std::endl;
     
@@ -125,6 +231,12 @@ int main() {
     RUN_TEST(test_input_parsing);
     RUN_TEST(test_memory_handling);
     RUN_TEST(test_string_modification);
+    RUN_TEST(test_process_length_aware);
+    RUN_TEST(test_process_length_aware_no_modification);
+    RUN_TEST(test_find_delimiters);
+    RUN_TEST(test_process_many_fields);
+    RUN_TEST(test_process_records);
+    RUN_TEST(test_process_stream);
     
     // Print summary
     std::cout << std::endl << "=== Test Results ===" << std::endl;
@@ -155,3 +155,70 @@ pub struct ValidationCommand {
     #[serde(default)]
     pub verify_files: Option<Vec<String>>,
 }
+
+/// A function declared in a project header, as found by the per-function
+/// harness generator
+#[derive(Debug, Clone)]
+pub struct HeaderFunction {
+    /// Name to call it by, namespace-qualified
+    pub name: String,
+    pub return_type: String,
+    pub params: Vec<HeaderParam>,
+    /// Path to #include it by, relative to the header root
+    pub header: String,
+}
+
+#[derive(Debug, Clone)]
+pub struct HeaderParam {
+    /// Normalized type: single spaces, no space before '*' or '&'
+    pub ty: String,
+    pub name: Option<String>,
+}
+
+/// Result of generating per-function harnesses
+#[derive(Debug, Default)]
+pub struct GeneratedHarnesses {
+    /// Harness stems written to fuzz/src/<stem>.cpp
+    pub harnesses: Vec<String>,
+    /// Functions without a harness, with the reason
+    pub skipped: Vec<(String, String)>,
+}
+
+/// A `--batch` manifest: defaults at the top, then one `[[project]]` table
+/// per project to scaffold
+#[derive(Debug, Deserialize, Serialize)]
+pub struct BatchManifest {
+    #[serde(flatten)]
+    pub defaults: BatchSettings,
+    #[serde(default, rename = "project")]
+    pub projects: Vec<BatchProject>,
+}
+
+#[derive(Debug, Deserialize, Serialize)]
+pub struct BatchProject {
+    /// Output directory relative to the manifest, used as the project name
+    pub path: String,
+    #[serde(flatten)]
+    pub settings: BatchSettings,
+}
+
+/// Settings a project entry may override; unset ones fall back to the
+/// manifest's, then to the command line
+#[derive(Debug, Deserialize, Serialize, Default)]
+pub struct BatchSettings {
+    #[serde(default)]
+    pub language: Option<String>,
+    #[serde(default)]
+    pub template: Option<String>,
+    #[serde(default)]
+    pub integration: Option<String>,
+    #[serde(default)]
+    pub minimal: Option<bool>,
+}
+
+/// Files a batch render wrote, and the ones already up to date
+#[derive(Debug, Default, Clone, Copy)]
+pub struct RenderStats {
+    pub written: usize,
+    pub unchanged: usize,
+}